@@ -0,0 +1,139 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CSR_H
+#define CSR_H
+
+#include <vector>
+#include <stddef.h>
+
+/*
+ * The view of the hyperlink matrix of Table that the calculations kept
+ * outside of it work on, and helpers shared with them.
+ */
+
+/*
+ * Number of consecutive rows that make up a block. Blocks are the unit
+ * of work of the threads, and sums over the rows are taken per block
+ * and then added in block order, so that they do not depend on the
+ * number of threads.
+ */
+const size_t BLOCK_ROWS = 4096;
+
+/*
+ * A read-only view of rows packed as in Table (CSR): row i holds the
+ * vertices cols[offsets[i]] up to, but not including,
+ * cols[offsets[i + 1]], sorted. The rows are either the incoming links
+ * of each vertex or its outgoing ones; inv_outgoing holds the
+ * reciprocal of the number of outgoing links of each vertex, or 0 for
+ * dangling vertices, either way.
+ */
+template <class Index>
+struct Csr {
+    const std::vector<size_t> &offsets;
+    const std::vector<Index> &cols;
+    const std::vector<double> &inv_outgoing;
+
+    size_t num_rows() const {
+        return offsets.size() - 1;
+    }
+
+    bool dangling(size_t v) const {
+        return inv_outgoing[v] == 0;
+    }
+};
+
+/*
+ * The settings of the iterations of Table that the calculations kept
+ * outside of it follow.
+ */
+struct IterationSettings {
+    double alpha; // the pagerank damping factor
+    double convergence; // L1 difference of successive iterations at
+                        // which they stop
+    unsigned long max_iterations;
+    unsigned int num_threads;
+};
+
+/*
+ * Splits num_rows rows, the start of row i of which is offset(i), in
+ * blocks of consecutive rows, into num_parts ranges with about the same
+ * number of arcs plus rows each, so that rows with many incoming links
+ * do not hold back a single part. Range t comprises blocks bounds[t] up
+ * to, but not including, bounds[t + 1]. Only about num_parts times the
+ * logarithm of the number of blocks offsets are asked for.
+ */
+template <class Offset>
+void partition_rows(size_t num_rows, const Offset &offset,
+                    std::vector<size_t> &bounds, unsigned int num_parts) {
+
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    /* The arcs plus rows preceding the given row */
+    auto weight = [&](size_t row) {
+        return offset(row) + row;
+    };
+    size_t total = weight(num_rows);
+
+    bounds.assign(num_parts + 1, num_blocks);
+    bounds[0] = 0;
+    for (unsigned int t = 1; t < num_parts; t++) {
+        size_t target = total / num_parts * t
+            + total % num_parts * t / num_parts;
+        /* The first block that starts at or after the target weight */
+        size_t lo = bounds[t - 1], hi = num_blocks;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (weight(mid * BLOCK_ROWS) < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bounds[t] = lo;
+    }
+}
+
+/*
+ * Splits the rows whose starts are given by offsets as above.
+ */
+inline void partition_rows(const std::vector<size_t> &offsets,
+                           std::vector<size_t> &bounds,
+                           unsigned int num_parts) {
+
+    partition_rows(offsets.size() - 1,
+                   [&](size_t row) { return offsets[row]; },
+                   bounds, num_parts);
+}
+
+#endif
@@ -0,0 +1,164 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+ 
+   All rights reserved.
+  
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ 
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ 
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+ 
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "dictionary.h"
+#include "snapshot.h"
+
+/*
+ * The low bits of a hash table slot hold the index of the name plus
+ * one, the high bits hold the high bits of the hash of the name.
+ */
+const int INDEX_BITS = 40;
+const uint64_t INDEX_MASK = (((uint64_t) 1) << INDEX_BITS) - 1;
+
+/* Initial number of hash table slots; always a power of two */
+const size_t INITIAL_SLOTS = 1024;
+
+Dictionary::Dictionary()
+    : offsets(1, 0),
+      slots(INITIAL_SLOTS, 0) {
+}
+
+uint64_t Dictionary::hash(string_view name) {
+
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.size(); i++) {
+        h ^= (unsigned char) name[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+size_t Dictionary::find_slot(string_view name, uint64_t h) const {
+
+    size_t mask = slots.size() - 1;
+    uint64_t tag = h & ~INDEX_MASK;
+    size_t s = (h ^ (h >> 29)) & mask;
+
+    while (slots[s] != 0) {
+        if ((slots[s] & ~INDEX_MASK) == tag
+            && this->name((slots[s] & INDEX_MASK) - 1) == name) {
+            break;
+        }
+        s = (s + 1) & mask;
+    }
+    return s;
+}
+
+void Dictionary::grow() {
+
+    slots.assign(slots.size() * 2, 0);
+    for (size_t i = 0; i < size(); i++) {
+        string_view key = name(i);
+        uint64_t h = hash(key);
+        slots[find_slot(key, h)] = (h & ~INDEX_MASK) | (i + 1);
+    }
+}
+
+size_t Dictionary::insert(string_view name) {
+
+    uint64_t h = hash(name);
+    size_t s = find_slot(name, h);
+    if (slots[s] != 0) {
+        return (slots[s] & INDEX_MASK) - 1;
+    }
+
+    size_t index = size();
+    arena.insert(arena.end(), name.begin(), name.end());
+    offsets.push_back(arena.size());
+    slots[s] = (h & ~INDEX_MASK) | (index + 1);
+    /* Keep the load factor at most one half */
+    if (2 * size() > slots.size()) {
+        grow();
+    }
+    return index;
+}
+
+size_t Dictionary::find(string_view name) const {
+
+    size_t s = find_slot(name, hash(name));
+    return (slots[s] != 0) ? (slots[s] & INDEX_MASK) - 1 : npos;
+}
+
+string_view Dictionary::name(size_t index) const {
+
+    if (index >= size()) {
+        return string_view();
+    }
+    return string_view(arena.data() + offsets[index],
+                       offsets[index + 1] - offsets[index]);
+}
+
+size_t Dictionary::size() const {
+    return offsets.size() - 1;
+}
+
+void Dictionary::clear() {
+    vector<char>().swap(arena);
+    offsets.assign(1, 0);
+    slots.assign(INITIAL_SLOTS, 0);
+}
+
+void Dictionary::write(ostream &out) const {
+
+    vector<uint64_t> sizes(3);
+    sizes[0] = size();
+    sizes[1] = arena.size();
+    sizes[2] = slots.size();
+    write_section(out, sizes);
+    write_section(out, offsets);
+    write_section(out, slots);
+    write_section(out, arena);
+}
+
+bool Dictionary::read(const char *&p, const char *end) {
+
+    vector<uint64_t> sizes;
+    if (!read_section(p, end, sizes, 3)) {
+        return false;
+    }
+    /* The number of slots must be a power of two, above the names */
+    if (sizes[2] == 0 || (sizes[2] & (sizes[2] - 1)) != 0
+        || sizes[0] >= sizes[2]) {
+        return false;
+    }
+    if (!read_section(p, end, offsets, sizes[0] + 1)
+        || !read_section(p, end, slots, sizes[2])
+        || !read_section(p, end, arena, sizes[1])
+        || offsets.back() != arena.size()) {
+        clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,133 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+ 
+   All rights reserved.
+  
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ 
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ 
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+ 
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <string_view>
+#include <stdint.h>
+
+using namespace std;
+
+/*
+ * A dictionary of vertex names, mapping each name to a dense index,
+ * starting from zero, in order of insertion, and back.
+ *
+ * All names are stored one after the other in a single character
+ * arena, and the start of each name in the arena is kept in an array
+ * indexed by the name index, so looking up the name of an index is a
+ * plain array access. The mapping from names to indices is an open
+ * addressing hash table with linear probing; each slot holds the index
+ * of a name together with some bits of the hash of the name, so that
+ * most mismatches are resolved without touching the arena.
+ */
+class Dictionary {
+private:
+
+    vector<char> arena; // the names, one after the other
+    vector<size_t> offsets; // start of each name in the arena, followed
+                            // by the end of the last name
+    vector<uint64_t> slots; // the hash table; 0 marks an empty slot
+
+    /*
+     * Returns the FNV-1a hash of name.
+     */
+    static uint64_t hash(string_view name);
+
+    /*
+     * Returns the position of name in the hash table: either the slot
+     * holding it, or the empty slot where it would be inserted.
+     */
+    size_t find_slot(string_view name, uint64_t h) const;
+
+    /*
+     * Doubles the size of the hash table and reinserts all the names.
+     */
+    void grow();
+
+public:
+
+    /* The value returned by find() for names not in the dictionary */
+    static const size_t npos = (size_t) -1;
+
+    Dictionary();
+
+    /*
+     * Returns the index of name, adding it to the dictionary with the
+     * next available index if it is not already there.
+     */
+    size_t insert(string_view name);
+
+    /*
+     * Returns the index of name, or npos if name is not in the
+     * dictionary.
+     */
+    size_t find(string_view name) const;
+
+    /*
+     * Returns the name with the given index. The view is valid until the
+     * next insertion.
+     */
+    string_view name(size_t index) const;
+
+    /*
+     * Returns the number of names in the dictionary.
+     */
+    size_t size() const;
+
+    /*
+     * Removes all names from the dictionary.
+     */
+    void clear();
+
+    /*
+     * Writes the dictionary, including its hash table, to out as
+     * snapshot sections (see snapshot.h).
+     */
+    void write(ostream &out) const;
+
+    /*
+     * Replaces the contents of the dictionary with the one written by
+     * write() in the memory starting at p and ending before end; the
+     * hash table is read as is, not rebuilt. Advances p past the
+     * dictionary. Returns false if the data do not hold a valid
+     * dictionary.
+     */
+    bool read(const char *&p, const char *end);
+};
+
+#endif
@@ -0,0 +1,784 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "distributed.h"
+#include "parallel.h"
+#include "snapshot.h"
+#include "sockets.h"
+
+/*
+ * How many times, WORKER_RETRY_MS milliseconds apart, independently
+ * started workers try to reach the first one before giving up.
+ */
+const unsigned int WORKER_CONNECT_ATTEMPTS = 600;
+const unsigned int WORKER_RETRY_MS = 100;
+
+/*
+ * The longest message that workers accept while connecting.
+ */
+const uint64_t MAX_HANDSHAKE_BYTES = 1 << 20;
+
+/*
+ * The rows first up to, but not including, first + offsets.size() - 1
+ * of a graph of num_rows vertices, packed as in Csr with offsets
+ * starting at 0, and the reciprocal of the number of outgoing links of
+ * each of them.
+ */
+template <class Index>
+struct RowSlice {
+    size_t num_rows;
+    size_t first;
+    vector<size_t> offsets;
+    vector<Index> cols;
+    vector<double> inv_outgoing;
+};
+
+/*
+ * Copies the rows first up to last of in_rows into slice.
+ */
+template <class Index>
+static void slice_rows(const Csr<Index> &in_rows, size_t first, size_t last,
+                       RowSlice<Index> &slice) {
+
+    slice.num_rows = in_rows.num_rows();
+    slice.first = first;
+    slice.offsets.resize(last - first + 1);
+    for (size_t i = 0; i <= last - first; i++) {
+        slice.offsets[i] = in_rows.offsets[first + i]
+            - in_rows.offsets[first];
+    }
+    slice.cols.assign(in_rows.cols.begin() + in_rows.offsets[first],
+                      in_rows.cols.begin() + in_rows.offsets[last]);
+    slice.inv_outgoing.assign(in_rows.inv_outgoing.begin() + first,
+                              in_rows.inv_outgoing.begin() + last);
+}
+
+/*
+ * Reads the rows first up to last of the snapshot open in fd into
+ * slice. Returns false if they cannot be read or are invalid.
+ */
+template <class Index>
+static bool read_slice(int fd, const StreamedRows &rows, size_t first,
+                       size_t last, RowSlice<Index> &slice) {
+
+    size_t num_own = last - first;
+
+    slice.num_rows = rows.num_rows;
+    slice.first = first;
+    slice.offsets.resize(num_own + 1);
+    if (!read_at(fd, rows.offsets_pos + first * sizeof(size_t),
+                 slice.offsets.data(), (num_own + 1) * sizeof(size_t))) {
+        return false;
+    }
+    size_t start = slice.offsets[0];
+    for (size_t i = 1; i <= num_own; i++) {
+        if (slice.offsets[i] < slice.offsets[i - 1]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i <= num_own; i++) {
+        slice.offsets[i] -= start;
+    }
+
+    slice.cols.resize(slice.offsets[num_own]);
+    if (!read_at(fd, rows.cols_pos + start * sizeof(Index), slice.cols.data(),
+                 slice.cols.size() * sizeof(Index))) {
+        return false;
+    }
+    for (size_t k = 0; k < slice.cols.size(); k++) {
+        if (slice.cols[k] >= rows.num_rows) {
+            return false;
+        }
+    }
+
+    vector<size_t> num_outgoing(num_own);
+    if (!read_at(fd, rows.outgoing_pos + first * sizeof(size_t),
+                 num_outgoing.data(), num_own * sizeof(size_t))) {
+        return false;
+    }
+    slice.inv_outgoing.resize(num_own);
+    for (size_t i = 0; i < num_own; i++) {
+        slice.inv_outgoing[i] = (num_outgoing[i])
+            ? 1.0 / num_outgoing[i]
+            : 0.0;
+    }
+    return true;
+}
+
+/*
+ * Splits the rows whose starts are given by offset among num_workers
+ * workers, as described in Table::set_num_processes(): worker w owns the
+ * rows row_bounds[w] up to row_bounds[w + 1].
+ */
+template <class Offset>
+static void worker_bounds(size_t num_rows, const Offset &offset,
+                          unsigned int num_workers,
+                          vector<size_t> &row_bounds) {
+
+    vector<size_t> bounds;
+    partition_rows(num_rows, offset, bounds, num_workers);
+    row_bounds.resize(num_workers + 1);
+    for (unsigned int w = 0; w <= num_workers; w++) {
+        row_bounds[w] = min(bounds[w] * BLOCK_ROWS, num_rows);
+    }
+}
+
+/*
+ * Performs the power iterations of worker w, which owns the rows of
+ * slice, row_bounds[w] up to row_bounds[w + 1], and is connected to
+ * worker p by fds[p], starting from the pagerank of its rows in own_pr
+ * and leaving their results in it, and leaves the number of iterations
+ * in num_iterations. Renumbers the column indices of slice. Returns
+ * false if a connection fails.
+ */
+template <class Index, class Value>
+static bool worker_iterate(RowSlice<Index> &slice,
+                           const vector<size_t> &row_bounds, unsigned int w,
+                           const vector<int> &fds,
+                           const IterationSettings &settings,
+                           vector<Value> &own_pr,
+                           unsigned long &num_iterations) {
+
+    double diff = 1;
+    size_t num_rows = slice.num_rows;
+    unsigned int num_workers = fds.size();
+    size_t first = row_bounds[w];
+    size_t num_own = row_bounds[w + 1] - first;
+    const vector<size_t> &offsets = slice.offsets;
+    vector<Index> &cols = slice.cols;
+    const vector<double> &inv_outgoing = slice.inv_outgoing;
+    double alpha = settings.alpha;
+    unsigned int num_threads = settings.num_threads;
+
+    vector<size_t> bounds;
+    partition_rows(offsets, bounds, num_threads);
+    auto first_arc = [&](unsigned int t) {
+        return offsets[min(bounds[t] * BLOCK_ROWS, num_own)];
+    };
+
+    /*
+     * The vertices of the other workers that link to the rows of this
+     * one, sorted, so that those of worker p, whose shares it receives
+     * in every iteration, are ghosts[ghost_bounds[p]] up to
+     * ghosts[ghost_bounds[p + 1]], ...
+     */
+    vector<Index> ghosts;
+    for (size_t k = 0; k < cols.size(); k++) {
+        if (cols[k] < first || cols[k] >= first + num_own) {
+            ghosts.push_back(cols[k]);
+        }
+    }
+    sort(ghosts.begin(), ghosts.end());
+    ghosts.erase(unique(ghosts.begin(), ghosts.end()), ghosts.end());
+    ghosts.shrink_to_fit();
+    vector<size_t> ghost_bounds(num_workers + 1);
+    for (unsigned int p = 0; p <= num_workers; p++) {
+        ghost_bounds[p] = lower_bound(ghosts.begin(), ghosts.end(),
+                                      row_bounds[p]) - ghosts.begin();
+    }
+    size_t num_ghosts = ghosts.size();
+
+    /*
+     * ... and the column indices are renumbered to point into the
+     * shares of the own vertices, followed by those of the ghosts.
+     */
+    run_parallel(num_threads, [&](unsigned int t) {
+        for (size_t k = first_arc(t); k < first_arc(t + 1); k++) {
+            size_t v = cols[k];
+            cols[k] = (v >= first && v < first + num_own)
+                ? v - first
+                : num_own + (lower_bound(ghosts.begin(), ghosts.end(), v)
+                             - ghosts.begin());
+        }
+    });
+
+    /*
+     * The vertices of this one that link to the rows of each other
+     * worker, whose shares it sends, as the other asks for them.
+     */
+    vector< vector<Index> > shared(num_workers);
+    vector< vector<char> > out(num_workers), in(num_workers);
+    for (unsigned int p = 0; p < num_workers; p++) {
+        if (p != w) {
+            uint64_t count = ghost_bounds[p + 1] - ghost_bounds[p];
+            out[p].assign((const char *) &count,
+                          (const char *) (&count + 1));
+            in[p].resize(sizeof(count));
+        }
+    }
+    if (!exchange(fds, out, in)) {
+        return false;
+    }
+    for (unsigned int p = 0; p < num_workers; p++) {
+        if (p != w) {
+            uint64_t count;
+            memcpy(&count, in[p].data(), sizeof(count));
+            if (count > num_own) {
+                return false;
+            }
+            out[p].assign((const char *) (ghosts.data() + ghost_bounds[p]),
+                          (const char *) (ghosts.data()
+                                          + ghost_bounds[p + 1]));
+            in[p].resize(count * sizeof(Index));
+        }
+    }
+    if (!exchange(fds, out, in)) {
+        return false;
+    }
+    vector<Index>().swap(ghosts);
+    for (unsigned int p = 0; p < num_workers; p++) {
+        if (p != w) {
+            const Index *indices = (const Index *) in[p].data();
+            size_t count = in[p].size() / sizeof(Index);
+            shared[p].resize(count);
+            for (size_t k = 0; k < count; k++) {
+                if (indices[k] < first || indices[k] >= first + num_own) {
+                    return false;
+                }
+                shared[p][k] = indices[k] - first;
+            }
+        }
+    }
+
+    /*
+     * The pagerank of the own rows and its previous, normalised, value,
+     * and the shares of the own and the ghost vertices; the shares of
+     * the ghosts are received unnormalised.
+     */
+    vector<Value> cur_pr;
+    cur_pr.swap(own_pr);
+    vector<Value> old_pr(num_own);
+    vector<Value> out_pr(num_own + num_ghosts);
+
+    /*
+     * Each round of messages carries the sums of the difference, the
+     * pagerank and its dangling part over the rows of the sender,
+     * followed by the shares that the receiver needs of its vertices.
+     * The sums of all the workers are added in worker order, so that
+     * every worker gets the same totals.
+     */
+    const size_t NUM_SUMS = 3;
+    const size_t SUMS_BYTES = NUM_SUMS * sizeof(double);
+    double sums[NUM_SUMS]; // of this worker
+    double totals[NUM_SUMS]; // of all the workers
+    for (unsigned int p = 0; p < num_workers; p++) {
+        if (p != w) {
+            out[p].resize(SUMS_BYTES + shared[p].size() * sizeof(Value));
+            in[p].resize(SUMS_BYTES + (ghost_bounds[p + 1] - ghost_bounds[p])
+                         * sizeof(Value));
+        }
+    }
+    auto send_round = [&]() {
+        for (unsigned int p = 0; p < num_workers; p++) {
+            if (p == w) {
+                continue;
+            }
+            memcpy(out[p].data(), sums, SUMS_BYTES);
+            Value *values = (Value *) (out[p].data() + SUMS_BYTES);
+            for (size_t k = 0; k < shared[p].size(); k++) {
+                size_t i = shared[p][k];
+                values[k] = inv_outgoing[i] * cur_pr[i];
+            }
+        }
+        if (!exchange(fds, out, in)) {
+            return false;
+        }
+        for (size_t s = 0; s < NUM_SUMS; s++) {
+            totals[s] = 0;
+        }
+        for (unsigned int p = 0; p < num_workers; p++) {
+            double p_sums[NUM_SUMS];
+            if (p == w) {
+                memcpy(p_sums, sums, SUMS_BYTES);
+            } else {
+                memcpy(p_sums, in[p].data(), SUMS_BYTES);
+                const Value *values = (const Value *) (in[p].data()
+                                                       + SUMS_BYTES);
+                copy(values, values + (ghost_bounds[p + 1] - ghost_bounds[p]),
+                     out_pr.begin() + num_own + ghost_bounds[p]);
+            }
+            for (size_t s = 0; s < NUM_SUMS; s++) {
+                totals[s] += p_sums[s];
+            }
+        }
+        return true;
+    };
+
+    /* Per block sums over the own rows */
+    size_t num_blocks = (num_own + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    vector<double> block_sum(num_blocks);
+    vector<double> block_dangling(num_blocks);
+    vector<double> block_diff(num_blocks);
+
+    sums[0] = 0;
+    sums[1] = 0;
+    sums[2] = 0;
+    for (size_t i = 0; i < num_own; i++) {
+        sums[1] += cur_pr[i];
+        if (inv_outgoing[i] == 0) {
+            sums[2] += cur_pr[i];
+        }
+    }
+    if (!send_round()) {
+        return false;
+    }
+
+    num_iterations = 0;
+    while (diff > settings.convergence
+           && num_iterations < settings.max_iterations) {
+
+        double sum_pr = totals[1];
+        double dangling_pr = totals[2];
+
+        /*
+         * Normalize so that we start with sum equal to one; the initial
+         * vector is used as is.
+         */
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first_row = min(bounds[t] * BLOCK_ROWS, num_own);
+            size_t last_row = min(bounds[t + 1] * BLOCK_ROWS, num_own);
+            for (size_t i = first_row; i < last_row; i++) {
+                old_pr[i] = (num_iterations == 0)
+                    ? cur_pr[i]
+                    : cur_pr[i] / sum_pr;
+                out_pr[i] = inv_outgoing[i] * old_pr[i];
+            }
+        });
+        if (num_iterations > 0) {
+            for (size_t k = num_own; k < num_own + num_ghosts; k++) {
+                out_pr[k] /= sum_pr;
+            }
+        }
+
+        /* The elements of the A x I and 1 x I vectors */
+        double one_Av = alpha * dangling_pr / num_rows;
+        double one_Iv = (1 - alpha) / num_rows;
+
+        run_parallel(num_threads, [&](unsigned int t) {
+            for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+                size_t last_row = min((b + 1) * BLOCK_ROWS, num_own);
+                double b_diff = 0, b_sum = 0, b_dangling = 0;
+                for (size_t i = b * BLOCK_ROWS; i < last_row; i++) {
+                    double h = 0.0;
+                    const Index *ci; // current incoming
+                    const Index *row_end = cols.data() + offsets[i + 1];
+                    for (ci = cols.data() + offsets[i]; ci != row_end; ci++) {
+                        h += out_pr[*ci];
+                    }
+                    cur_pr[i] = alpha * h + one_Av + one_Iv;
+                    b_diff += fabs(cur_pr[i] - old_pr[i]);
+                    b_sum += cur_pr[i];
+                    if (inv_outgoing[i] == 0) {
+                        b_dangling += cur_pr[i];
+                    }
+                }
+                block_diff[b] = b_diff;
+                block_sum[b] = b_sum;
+                block_dangling[b] = b_dangling;
+            }
+        });
+
+        sums[0] = 0;
+        sums[1] = 0;
+        sums[2] = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            sums[0] += block_diff[b];
+            sums[1] += block_sum[b];
+            sums[2] += block_dangling[b];
+        }
+        num_iterations++;
+        if (!send_round()) {
+            return false;
+        }
+        diff = totals[0];
+    }
+
+    own_pr.swap(cur_pr);
+    return true;
+}
+
+/*
+ * Collects the pagerank of the rows of every worker, own_pr of worker
+ * w, in pr of the first worker, whose size it sets to the number of
+ * vertices. Returns false if a connection fails.
+ */
+template <class Value>
+static bool gather_pagerank(unsigned int w, const vector<int> &fds,
+                            const vector<size_t> &row_bounds,
+                            const vector<Value> &own_pr,
+                            vector<double> &pr) {
+
+    unsigned int num_workers = fds.size();
+    vector< vector<char> > out(num_workers), in(num_workers);
+
+    if (w > 0) {
+        vector<int> to_first(num_workers, -1);
+        to_first[0] = fds[0];
+        out[0].assign((const char *) own_pr.data(),
+                      (const char *) (own_pr.data() + own_pr.size()));
+        return exchange(to_first, out, in);
+    }
+
+    for (unsigned int p = 1; p < num_workers; p++) {
+        in[p].resize((row_bounds[p + 1] - row_bounds[p]) * sizeof(Value));
+    }
+    if (!exchange(fds, out, in)) {
+        return false;
+    }
+    pr.resize(row_bounds[num_workers]);
+    copy(own_pr.begin(), own_pr.end(), pr.begin());
+    for (unsigned int p = 1; p < num_workers; p++) {
+        const Value *values = (const Value *) in[p].data();
+        copy(values, values + (row_bounds[p + 1] - row_bounds[p]),
+             pr.begin() + row_bounds[p]);
+    }
+    return true;
+}
+
+template <class Index, class Value>
+bool distributed_iterate(const Csr<Index> &in_rows,
+                         const IterationSettings &settings,
+                         unsigned int num_workers, vector<double> &pr,
+                         unsigned long &num_iterations) {
+
+    vector<size_t> row_bounds;
+    worker_bounds(in_rows.num_rows(),
+                  [&](size_t row) { return in_rows.offsets[row]; },
+                  num_workers, row_bounds);
+
+    /* A socket for each pair of workers; fds[w][p] is the end of w */
+    vector< vector<int> > fds(num_workers, vector<int>(num_workers, -1));
+    for (unsigned int w = 0; w < num_workers; w++) {
+        for (unsigned int p = w + 1; p < num_workers; p++) {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+                return false;
+            }
+            fds[w][p] = sv[0];
+            fds[p][w] = sv[1];
+        }
+    }
+    /* Closes the ends of the sockets of all the workers but w */
+    auto close_others = [&](unsigned int w) {
+        for (unsigned int v = 0; v < num_workers; v++) {
+            for (unsigned int p = 0; p < num_workers; p++) {
+                if (v != w && fds[v][p] >= 0) {
+                    close(fds[v][p]);
+                }
+            }
+        }
+    };
+    /* Calculates the pagerank of the rows of worker w */
+    auto work = [&](unsigned int w) {
+        RowSlice<Index> slice;
+        slice_rows(in_rows, row_bounds[w], row_bounds[w + 1], slice);
+        vector<Value> own_pr(pr.begin() + row_bounds[w],
+                             pr.begin() + row_bounds[w + 1]);
+        return worker_iterate<Index, Value>(slice, row_bounds, w, fds[w],
+                                            settings, own_pr, num_iterations)
+            && gather_pagerank(w, fds[w], row_bounds, own_pr, pr);
+    };
+
+    /*
+     * The calling process is worker 0. The others are forked from it,
+     * so they start with the graph in memory, but each of them copies
+     * only its own rows; they send their results to worker 0 and exit.
+     */
+    cout.flush();
+    cerr.flush();
+    vector<pid_t> pids;
+    for (unsigned int w = 1; w < num_workers; w++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            return false;
+        }
+        if (pid == 0) {
+            close_others(w);
+            _exit((work(w)) ? 0 : 1);
+        }
+        pids.push_back(pid);
+    }
+    close_others(0);
+
+    bool ok = work(0);
+
+    /* Closing its sockets also stops the workers if one has failed */
+    for (unsigned int w = 1; w < num_workers; w++) {
+        close(fds[0][w]);
+    }
+    for (size_t k = 0; k < pids.size(); k++) {
+        int status;
+        if (waitpid(pids[k], &status, 0) < 0 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*
+ * Sends message on fd, preceded by its length.
+ */
+static bool send_message(int fd, const string &message) {
+
+    vector<int> fds(1, fd);
+    vector< vector<char> > out(1), in(1);
+    uint64_t size = message.size();
+    out[0].assign((const char *) &size, (const char *) (&size + 1));
+    out[0].insert(out[0].end(), message.begin(), message.end());
+    return exchange(fds, out, in);
+}
+
+/*
+ * Receives a message sent by send_message() on fd.
+ */
+static bool receive_message(int fd, string &message) {
+
+    vector<int> fds(1, fd);
+    vector< vector<char> > out(1), in(1);
+    uint64_t size;
+    in[0].resize(sizeof(size));
+    if (!exchange(fds, out, in)) {
+        return false;
+    }
+    memcpy(&size, in[0].data(), sizeof(size));
+    if (size > MAX_HANDSHAKE_BYTES) {
+        return false;
+    }
+    in[0].resize(size);
+    if (!exchange(fds, out, in)) {
+        return false;
+    }
+    message.assign(in[0].begin(), in[0].end());
+    return true;
+}
+
+bool connect_workers(const string &address, unsigned int w,
+                     unsigned int num_workers, const string &agreed,
+                     vector<int> &fds) {
+
+    fds.assign(num_workers, -1);
+    if (num_workers == 1) {
+        return true;
+    }
+
+    bool ok = true;
+    string listened; // the address this worker listens on
+    int listen_fd = -1;
+    vector<string> addresses(num_workers);
+
+    /*
+     * Accepts a connection from a worker after w, which introduces
+     * itself as "p\nagreed\naddress" to the first worker and as "p" to
+     * the others; the first worker keeps its address.
+     */
+    auto accept_worker = [&]() {
+        int fd = accept(listen_fd, NULL, NULL);
+        string hello;
+        if (fd < 0 || !receive_message(fd, hello)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        istringstream in(hello);
+        unsigned long p = 0;
+        string p_agreed, p_address;
+        in >> p;
+        if (w == 0) {
+            in.get();
+            getline(in, p_agreed);
+            getline(in, p_address);
+        }
+        if (in.fail() || p <= w || p >= num_workers || fds[p] >= 0
+            || (w == 0 && p_agreed != agreed)) {
+            close(fd);
+            return false;
+        }
+        fds[p] = fd;
+        addresses[p] = p_address;
+        return true;
+    };
+
+    if (w == 0) {
+        listen_fd = listen_socket(address);
+        ok = listen_fd >= 0;
+        listened = address;
+        for (unsigned int k = 1; ok && k < num_workers; k++) {
+            ok = accept_worker();
+        }
+        /* Every worker learns where all the others listen */
+        string table;
+        for (unsigned int p = 1; p < num_workers; p++) {
+            table += addresses[p] + "\n";
+        }
+        for (unsigned int p = 1; ok && p < num_workers; p++) {
+            ok = send_message(fds[p], table);
+        }
+    } else {
+        /* The first worker may not have been started yet */
+        for (unsigned int k = 0; fds[0] < 0 && k < WORKER_CONNECT_ATTEMPTS;
+             k++) {
+            fds[0] = connect_socket(address);
+            if (fds[0] < 0) {
+                usleep(WORKER_RETRY_MS * 1000);
+            }
+        }
+        ok = fds[0] >= 0;
+
+        /*
+         * Over TCP each worker listens on the host through which it
+         * reaches the first one, on a port of its own; over Unix domain
+         * sockets next to the first one.
+         */
+        if (ok && tcp_address(address)) {
+            listen_fd = listen_socket(local_address(fds[0], "0"));
+            listened = local_address(listen_fd);
+        } else if (ok) {
+            listened = address + "." + to_string(w);
+            listen_fd = listen_socket(listened);
+        }
+        ok = ok && listen_fd >= 0 && !listened.empty()
+            && send_message(fds[0], to_string(w) + "\n" + agreed + "\n"
+                            + listened);
+        string table;
+        ok = ok && receive_message(fds[0], table);
+        istringstream in(table);
+        for (unsigned int p = 1; ok && p < num_workers; p++) {
+            ok = (bool) getline(in, addresses[p]);
+        }
+
+        /* It connects to the workers before it, the rest connect to it */
+        for (unsigned int p = 1; ok && p < w; p++) {
+            fds[p] = connect_socket(addresses[p]);
+            ok = fds[p] >= 0 && send_message(fds[p], to_string(w));
+        }
+        for (unsigned int p = w + 1; ok && p < num_workers; p++) {
+            ok = accept_worker();
+        }
+    }
+
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        if (!tcp_address(listened)) {
+            unlink(listened.c_str());
+        }
+    }
+    if (!ok) {
+        for (unsigned int p = 0; p < num_workers; p++) {
+            if (fds[p] >= 0) {
+                close(fds[p]);
+            }
+        }
+    }
+    return ok;
+}
+
+template <class Index, class Value>
+bool snapshot_worker_iterate(const StreamedRows &rows,
+                             const IterationSettings &settings,
+                             unsigned int w, const vector<int> &fds,
+                             vector<double> &pr,
+                             unsigned long &num_iterations) {
+
+    int fd = open(rows.filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    /*
+     * Every worker splits the rows alike, reading the few row offsets
+     * that the split looks at, and then reads its own rows.
+     */
+    bool ok = true;
+    vector<size_t> row_bounds;
+    worker_bounds(rows.num_rows, [&](size_t row) {
+                      size_t offset = 0;
+                      ok = ok && read_at(fd, rows.offsets_pos
+                                         + row * sizeof(size_t),
+                                         &offset, sizeof(offset));
+                      return offset;
+                  }, fds.size(), row_bounds);
+    RowSlice<Index> slice;
+    ok = ok && read_slice(fd, rows, row_bounds[w], row_bounds[w + 1], slice);
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    /* All on the first vertex, as in Table::pagerank() */
+    vector<Value> own_pr(row_bounds[w + 1] - row_bounds[w], 0);
+    if (row_bounds[w] == 0 && !own_pr.empty()) {
+        own_pr[0] = 1;
+    }
+    return worker_iterate<Index, Value>(slice, row_bounds, w, fds, settings,
+                                        own_pr, num_iterations)
+        && gather_pagerank(w, fds, row_bounds, own_pr, pr);
+}
+
+template bool distributed_iterate<uint32_t, float>(
+    const Csr<uint32_t> &, const IterationSettings &, unsigned int,
+    vector<double> &, unsigned long &);
+template bool distributed_iterate<uint32_t, double>(
+    const Csr<uint32_t> &, const IterationSettings &, unsigned int,
+    vector<double> &, unsigned long &);
+template bool distributed_iterate<uint64_t, float>(
+    const Csr<uint64_t> &, const IterationSettings &, unsigned int,
+    vector<double> &, unsigned long &);
+template bool distributed_iterate<uint64_t, double>(
+    const Csr<uint64_t> &, const IterationSettings &, unsigned int,
+    vector<double> &, unsigned long &);
+template bool snapshot_worker_iterate<uint32_t, float>(
+    const StreamedRows &, const IterationSettings &, unsigned int,
+    const vector<int> &, vector<double> &, unsigned long &);
+template bool snapshot_worker_iterate<uint32_t, double>(
+    const StreamedRows &, const IterationSettings &, unsigned int,
+    const vector<int> &, vector<double> &, unsigned long &);
+template bool snapshot_worker_iterate<uint64_t, float>(
+    const StreamedRows &, const IterationSettings &, unsigned int,
+    const vector<int> &, vector<double> &, unsigned long &);
+template bool snapshot_worker_iterate<uint64_t, double>(
+    const StreamedRows &, const IterationSettings &, unsigned int,
+    const vector<int> &, vector<double> &, unsigned long &);
@@ -0,0 +1,100 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "csr.h"
+#include "stream.h"
+
+using namespace std;
+
+/*
+ * The power method of Table split among worker processes, as described
+ * in Table::set_num_processes() and Table::set_worker(). Each worker
+ * keeps only its own rows, and the shares of the vertices of the other
+ * workers that link to them.
+ */
+
+/*
+ * Performs the power iterations of Table::pagerank() on in_rows in
+ * num_workers worker processes forked from the calling one, which is
+ * the first worker, with the calculations carried out on values of
+ * type Value, starting from pr and leaving the results in it, and
+ * leaves the number of iterations in num_iterations. Returns false if
+ * a worker cannot be started or fails.
+ */
+template <class Index, class Value>
+bool distributed_iterate(const Csr<Index> &in_rows,
+                         const IterationSettings &settings,
+                         unsigned int num_workers, vector<double> &pr,
+                         unsigned long &num_iterations);
+
+/*
+ * Connects worker w of num_workers independently started ones to each
+ * of the others, through fds[p] to worker p. The first worker listens
+ * on address, and learns from each of the others the address it
+ * listens on in turn, which it passes on to all of them; every worker
+ * must give the same agreed description of the calculation. The others
+ * keep trying to reach the first one for a while, so the workers may be
+ * started in any order. Returns false if the workers cannot be
+ * connected or do not agree.
+ */
+bool connect_workers(const string &address, unsigned int w,
+                     unsigned int num_workers, const string &agreed,
+                     vector<int> &fds);
+
+/*
+ * Performs the power iterations of Table::pagerank() as worker w of the
+ * workers connected by fds, as connect_workers() leaves them, on the
+ * rows of the snapshot, with the calculations carried out on values of
+ * type Value. Each worker reads only the row offsets that it needs to
+ * find its rows, and its rows, from the snapshot. The first worker is
+ * left with the pagerank of all the vertices in pr, the others with
+ * none; all of them are left with the number of iterations in
+ * num_iterations. Returns false if the snapshot cannot be read or a
+ * connection fails.
+ */
+template <class Index, class Value>
+bool snapshot_worker_iterate(const StreamedRows &rows,
+                             const IterationSettings &settings,
+                             unsigned int w, const vector<int> &fds,
+                             vector<double> &pr,
+                             unsigned long &num_iterations);
+
+#endif
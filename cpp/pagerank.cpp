@@ -33,13 +33,21 @@
 */
 
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <cstdlib>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
 
 using namespace std;
 
 #include "table.h"
+#include "server.h"
 
 const char *TRACE_ARG = "-t";
 const char *NUMERIC_ARG = "-n";
@@ -48,13 +56,63 @@ const char *CONVERGENCE_ARG = "-c";
 const char *SIZE_ARG = "-s";
 const char *DELIM_ARG = "-d";
 const char *ITER_ARG = "-m";
+const char *THREADS_ARG = "-p";
+const char *PROCESSES_ARG = "--processes";
+const char *WORKER_ARG = "--worker";
+const char *RENDEZVOUS_ARG = "--rendezvous";
+const char *FLOAT_ARG = "-f";
+const char *WRITE_SNAPSHOT_ARG = "-w";
+const char *READ_SNAPSHOT_ARG = "-r";
+const char *BINARY_ARG = "-b";
+const char *STREAM_ARG = "-x";
+const char *START_ARG = "-i";
+const char *DELTAS_ARG = "--deltas";
+const char *PERSONALIZE_ARG = "--personalize";
+const char *MONTE_CARLO_ARG = "--monte-carlo";
+const char *LOCAL_ARG = "--local";
+const char *LOCAL_EPSILON_ARG = "--local-epsilon";
+const char *RUN_ARCS_ARG = "--run-arcs";
+const char *TOP_ARG = "--top";
+const char *SOLVER_ARG = "--solver";
+const char *EXTRAPOLATE_ARG = "--extrapolate";
+const char *EXTRAPOLATE_EVERY_ARG = "--extrapolate-every";
+const char *BIN_WIDTH_ARG = "--bin-width";
+const char *REORDER_ARG = "--reorder";
+const char *SKIP_TRIVIAL_ARG = "--skip-trivial";
+const char *ADAPTIVE_ARG = "--adaptive";
+const char *SERVE_ARG = "--serve";
+
+/*
+ * The iterations timed before reordering, to weigh the time spent on
+ * reordering against the time it saves per iteration.
+ */
+const unsigned long REORDER_PROBE_ITERATIONS = 3;
 
 void usage() {
-    cerr << "pagerank [-tn] [-a alpha ] [-s size] [-d delim] "
-         << "[-m max_iterations] <graph_file>" << endl
+    cerr << "pagerank [-tnfbx] [-a alpha ] [-s size] [-d delim] "
+         << "[-m max_iterations] [-p threads] [--top k]" << endl
+         << "         [--processes n] [--worker w/n --rendezvous address]"
+         << endl
+         << "         [--solver power|gauss-seidel]" << endl
+         << "         [--extrapolate none|aitken|quadratic] "
+         << "[--extrapolate-every n]" << endl
+         << "         [--bin-width n] [--reorder degree|rcm|gorder] "
+         << "[--skip-trivial] [--adaptive tolerance]" << endl
+         << "         [--personalize seed_file] [-i pagerank_file] "
+         << "[--deltas delta_file]" << endl
+         << "         [--monte-carlo walks] [--local seed] "
+         << "[--local-epsilon epsilon]" << endl
+         << "         [--run-arcs n] [--serve socket] [-w snapshot] "
+         << "[-r snapshot | <graph_file>]" << endl
          << " -t enable tracing " << endl
          << " -n treat graph file as numeric; i.e. input comprises "
          << "integer vertex names" << endl
+         << " -f calculate in single precision (float)" << endl
+         << " -b output the pagerank vector in binary form" << endl
+         << " -x stream the graph from the snapshot given with -r, or "
+         << "built with -w," << endl
+         << "    in every iteration, instead of keeping it in memory"
+         << endl
          << " -a alpha" << endl
          << "    the dumping factor " << endl
          << " -c convergence" << endl
@@ -65,7 +123,93 @@ void usage() {
          << "    delimiter for separating vertex names in each input"
          << "line " << endl
          << " -m max_iterations" << endl
-         << "    maximum number of iterations to perform" << endl;
+         << "    maximum number of iterations to perform" << endl
+         << " -p threads" << endl
+         << "    number of threads to use for the calculations" << endl
+         << " --processes n" << endl
+         << "    split the rows of the power method among n worker "
+         << "processes, which" << endl
+         << "    exchange the pagerank of the vertices linking across "
+         << "them over sockets" << endl
+         << " --worker w/n" << endl
+         << "    be worker w, counting from 0, of n workers started on "
+         << "their own, possibly" << endl
+         << "    on different hosts, each reading only its rows from the "
+         << "snapshot given" << endl
+         << "    with -r; worker 0 outputs the pagerank" << endl
+         << " --rendezvous address" << endl
+         << "    host:port, or the path of a Unix domain socket, on which "
+         << "worker 0 listens" << endl
+         << "    for the other workers" << endl
+         << " --solver power|gauss-seidel" << endl
+         << "    iterative method to use; gauss-seidel updates the "
+         << "pagerank vector in place" << endl
+         << " --extrapolate none|aitken|quadratic" << endl
+         << "    accelerate the power method by extrapolating from the "
+         << "last iterates" << endl
+         << " --extrapolate-every n" << endl
+         << "    power iterations between extrapolations, at least 2 "
+         << "for aitken and 3 for quadratic; "
+         << "default " << DEFAULT_EXTRAPOLATION_PERIOD << endl
+         << " --bin-width n" << endl
+         << "    add up the power method's contributions in bins of n "
+         << "destinations" << endl
+         << "    (propagation blocking), to keep random accesses in the "
+         << "cache" << endl
+         << " --skip-trivial" << endl
+         << "    iterate only over the vertices with both incoming and "
+         << "outgoing links" << endl
+         << " --adaptive tolerance" << endl
+         << "    freeze each vertex once its pagerank changes by at most "
+         << "tolerance times" << endl
+         << "    its value; about the convergence criterion works best"
+         << endl
+         << " --reorder degree|rcm|gorder" << endl
+         << "    renumber the vertices before calculating, for locality; "
+         << "the output" << endl
+         << "    keeps the original vertices" << endl
+         << " --top k" << endl
+         << "    output only the k vertices with the highest pagerank, "
+         << "highest first" << endl
+         << " -i pagerank_file" << endl
+         << "    start from the pagerank vector in pagerank_file, as "
+         << "output by a previous run" << endl
+         << " --personalize seed_file" << endl
+         << "    calculate the personalized pagerank of each seed set in "
+         << "seed_file, whose" << endl
+         << "    lines hold a set name and a vertex, instead of the "
+         << "pagerank" << endl
+         << " --monte-carlo walks" << endl
+         << "    estimate the pagerank by running the given number of "
+         << "random walks from" << endl
+         << "    each vertex, instead of iterating" << endl
+         << " --local seed" << endl
+         << "    approximate the personalized pagerank of vertex seed by "
+         << "pushing from it," << endl
+         << "    touching only the vertices near it, instead of the "
+         << "pagerank; with -, answer" << endl
+         << "    for each seed read from the standard input" << endl
+         << " --local-epsilon epsilon" << endl
+         << "    residual per outgoing arc left unpushed by --local; "
+         << "default " << DEFAULT_LOCAL_EPSILON << endl
+         << " --deltas delta_file" << endl
+         << "    after calculating the pagerank, apply the batches of arc "
+         << "changes in delta_file" << endl
+         << "    (- for the standard input), updating the pagerank "
+         << "after each batch" << endl
+         << " --run-arcs n" << endl
+         << "    arcs sorted in memory at a time when building the "
+         << "snapshot for -x; default " << DEFAULT_RUN_ARCS << endl
+         << " --serve socket" << endl
+         << "    after calculating the pagerank, answer RANK name, TOP k "
+         << "and ALPHA a" << endl
+         << "    requests on the given Unix domain socket instead of "
+         << "outputting it" << endl
+         << " -w snapshot" << endl
+         << "    write the graph to a binary snapshot file" << endl
+         << " -r snapshot" << endl
+         << "    read the graph from a binary snapshot file instead of "
+         << "a graph file" << endl;
 }
 
 int check_inc(int i, int max) {
@@ -81,6 +225,22 @@ int main(int argc, char **argv) {
     Table t;
     char *endptr;
     string input = "stdin";
+    string snapshot_out; // snapshot file to write, if any
+    string snapshot_in; // snapshot file to read, if any
+    string start_in; // pagerank file to start from, if any
+    string deltas_in; // file of batches of arc changes, if any
+    string seeds_in; // file of seed sets for personalized pagerank, if any
+    string local_seed; // vertex to approximate the pagerank from, if any
+    string serve_socket; // socket to serve requests on, if any
+    double local_epsilon = DEFAULT_LOCAL_EPSILON;
+    unsigned long walks = 0; // random walks from each vertex, 0 to iterate
+    bool binary_output = false;
+    bool streamed = false; // stream the graph from a snapshot
+    string ordering; // ordering to renumber the vertices by, if any
+    size_t top = 0; // number of top vertices to output, 0 for all
+    unsigned long worker = 0; // index of this process among the workers
+    unsigned long workers = 0; // workers started on their own, if any
+    string rendezvous; // address at which the workers meet
 
     int i = 1;
     while (i < argc) {
@@ -88,6 +248,14 @@ int main(int argc, char **argv) {
             t.set_trace(true);
         } else if (!strcmp(argv[i], NUMERIC_ARG)) {
             t.set_numeric(true);
+        } else if (!strcmp(argv[i], BINARY_ARG)) {
+            binary_output = true;
+        } else if (!strcmp(argv[i], SKIP_TRIVIAL_ARG)) {
+            t.set_skip_trivial(true);
+        } else if (!strcmp(argv[i], STREAM_ARG)) {
+            streamed = true;
+        } else if (!strcmp(argv[i], FLOAT_ARG)) {
+            t.set_single_precision(true);
         } else if (!strcmp(argv[i], ALPHA_ARG)) {
             i = check_inc(i, argc);
             double alpha = strtod(argv[i], &endptr);
@@ -120,6 +288,130 @@ int main(int argc, char **argv) {
                 exit(1);
             }
             t.set_max_iterations(iterations);
+        } else if (!strcmp(argv[i], THREADS_ARG)) {
+            i = check_inc(i, argc);
+            long threads = strtol(argv[i], &endptr, 10);
+            if (threads <= 0 && endptr) {
+                cerr << "Invalid threads argument" << endl;
+                exit(1);
+            }
+            t.set_num_threads(threads);
+        } else if (!strcmp(argv[i], PROCESSES_ARG)) {
+            i = check_inc(i, argc);
+            long processes = strtol(argv[i], &endptr, 10);
+            if (processes <= 0 && endptr) {
+                cerr << "Invalid processes argument" << endl;
+                exit(1);
+            }
+            t.set_num_processes(processes);
+        } else if (!strcmp(argv[i], WORKER_ARG)) {
+            i = check_inc(i, argc);
+            worker = strtoul(argv[i], &endptr, 10);
+            workers = (*endptr == '/') ? strtoul(endptr + 1, &endptr, 10) : 0;
+            if (workers == 0 || worker >= workers || *endptr) {
+                cerr << "Invalid worker argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], RENDEZVOUS_ARG)) {
+            i = check_inc(i, argc);
+            rendezvous = argv[i];
+        } else if (!strcmp(argv[i], SOLVER_ARG)) {
+            i = check_inc(i, argc);
+            if (!t.set_solver(argv[i])) {
+                cerr << "Invalid solver argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], EXTRAPOLATE_ARG)) {
+            i = check_inc(i, argc);
+            if (!t.set_extrapolation(argv[i])) {
+                cerr << "Invalid extrapolate argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], EXTRAPOLATE_EVERY_ARG)) {
+            i = check_inc(i, argc);
+            long period = strtol(argv[i], &endptr, 10);
+            if (period < 1 && endptr) {
+                cerr << "Invalid extrapolate-every argument" << endl;
+                exit(1);
+            }
+            t.set_extrapolation_period(period);
+        } else if (!strcmp(argv[i], RUN_ARCS_ARG)) {
+            i = check_inc(i, argc);
+            size_t n = strtoul(argv[i], &endptr, 10);
+            if (n == 0 && endptr) {
+                cerr << "Invalid run-arcs argument" << endl;
+                exit(1);
+            }
+            t.set_run_arcs(n);
+        } else if (!strcmp(argv[i], BIN_WIDTH_ARG)) {
+            i = check_inc(i, argc);
+            size_t width = strtoul(argv[i], &endptr, 10);
+            if (width == 0 && endptr) {
+                cerr << "Invalid bin-width argument" << endl;
+                exit(1);
+            }
+            t.set_bin_width(width);
+        } else if (!strcmp(argv[i], REORDER_ARG)) {
+            i = check_inc(i, argc);
+            ordering = argv[i];
+            int o = 0;
+            while (o < NUM_ORDERINGS && ordering != ORDERING_NAMES[o]) {
+                o++;
+            }
+            if (o == NUM_ORDERINGS) {
+                cerr << "Invalid reorder argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], ADAPTIVE_ARG)) {
+            i = check_inc(i, argc);
+            double tolerance = strtod(argv[i], &endptr);
+            if (tolerance <= 0 && endptr) {
+                cerr << "Invalid adaptive argument" << endl;
+                exit(1);
+            }
+            t.set_adaptive_tolerance(tolerance);
+        } else if (!strcmp(argv[i], TOP_ARG)) {
+            i = check_inc(i, argc);
+            top = strtol(argv[i], &endptr, 10);
+            if (top == 0 && endptr) {
+                cerr << "Invalid top argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], WRITE_SNAPSHOT_ARG)) {
+            i = check_inc(i, argc);
+            snapshot_out = argv[i];
+        } else if (!strcmp(argv[i], START_ARG)) {
+            i = check_inc(i, argc);
+            start_in = argv[i];
+        } else if (!strcmp(argv[i], PERSONALIZE_ARG)) {
+            i = check_inc(i, argc);
+            seeds_in = argv[i];
+        } else if (!strcmp(argv[i], MONTE_CARLO_ARG)) {
+            i = check_inc(i, argc);
+            walks = strtoul(argv[i], &endptr, 10);
+            if (walks == 0 && endptr) {
+                cerr << "Invalid monte-carlo argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], SERVE_ARG)) {
+            i = check_inc(i, argc);
+            serve_socket = argv[i];
+        } else if (!strcmp(argv[i], LOCAL_ARG)) {
+            i = check_inc(i, argc);
+            local_seed = argv[i];
+        } else if (!strcmp(argv[i], LOCAL_EPSILON_ARG)) {
+            i = check_inc(i, argc);
+            local_epsilon = strtod(argv[i], &endptr);
+            if (local_epsilon <= 0 && endptr) {
+                cerr << "Invalid local-epsilon argument" << endl;
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], DELTAS_ARG)) {
+            i = check_inc(i, argc);
+            deltas_in = argv[i];
+        } else if (!strcmp(argv[i], READ_SNAPSHOT_ARG)) {
+            i = check_inc(i, argc);
+            snapshot_in = argv[i];
         } else if (!strcmp(argv[i], DELIM_ARG)) {
             i = check_inc(i, argc);
             t.set_delim(argv[i]);
@@ -132,15 +424,259 @@ int main(int argc, char **argv) {
         i++;
     }
 
+    if (workers > 0) {
+        if (t.get_num_processes() > 1 && t.get_num_processes() != workers) {
+            cerr << "The number of processes and of workers differ" << endl;
+            exit(1);
+        }
+        t.set_num_processes(workers);
+        t.set_worker(worker, rendezvous);
+    }
+
     t.print_params(cerr);
-    cerr << "Reading input from " << input << "..." << endl;
-    if (!strcmp(input.c_str(), "stdin")) {
+    string conflict = t.check_settings();
+    if (!conflict.empty()) {
+        cerr << conflict << endl;
+        exit(1);
+    }
+    if (!ordering.empty() && (streamed || !seeds_in.empty()
+                              || !local_seed.empty() || !deltas_in.empty())) {
+        cerr << "Reordering only calculates or estimates the pagerank"
+             << endl;
+        exit(1);
+    }
+    if (!serve_socket.empty() && (walks > 0 || !seeds_in.empty()
+                                  || !local_seed.empty())) {
+        cerr << "Serving only calculates the pagerank" << endl;
+        exit(1);
+    }
+    if ((workers > 0) != !rendezvous.empty()) {
+        cerr << "Workers need both --worker and --rendezvous" << endl;
+        exit(1);
+    }
+    if (workers > 0 && (snapshot_in.empty() || !snapshot_out.empty()
+                        || streamed || t.get_trace() || !start_in.empty()
+                        || !ordering.empty() || !seeds_in.empty()
+                        || !local_seed.empty() || walks > 0
+                        || !deltas_in.empty() || !serve_socket.empty())) {
+        cerr << "Workers only calculate the pagerank of the snapshot given "
+             << "with -r" << endl;
+        exit(1);
+    }
+
+    /* Outputs the pagerank once it has been calculated */
+    auto output = [&]() {
+        if (top > 0) {
+            t.print_pagerank_top(top);
+        } else if (binary_output) {
+            t.print_pagerank_b();
+        } else {
+            t.print_pagerank_v();
+        }
+    };
+
+    if (workers > 0) {
+        cerr << "Calculating pagerank as worker " << worker << " of "
+             << workers << " at " << rendezvous << "..." << endl;
+        t.worker_pagerank(snapshot_in);
+        cerr << "Done calculating! (" << t.get_num_iterations()
+             << " iterations)" << endl;
+        /* Only the first worker is left with the pagerank */
+        if (worker == 0) {
+            output();
+        }
+        return 0;
+    }
+    if (streamed) {
+        if (snapshot_in.empty() == snapshot_out.empty()) {
+            cerr << "Streaming needs either -r or -w" << endl;
+            exit(1);
+        }
+        if (!seeds_in.empty() || !local_seed.empty() || walks > 0
+            || !deltas_in.empty()) {
+            cerr << "Streaming only calculates the pagerank" << endl;
+            exit(1);
+        }
+        if (!snapshot_out.empty()) {
+            cerr << "Building snapshot " << snapshot_out << " from " << input
+                 << "..." << endl;
+            t.build_snapshot((input == "stdin") ? "/dev/stdin" : input,
+                             snapshot_out);
+            snapshot_in = snapshot_out;
+            snapshot_out.clear();
+        }
+        cerr << "Opening snapshot " << snapshot_in << "..." << endl;
+        t.open_snapshot(snapshot_in);
+    } else if (!snapshot_in.empty()) {
+        cerr << "Reading snapshot from " << snapshot_in << "..." << endl;
+        t.read_snapshot(snapshot_in);
+    } else {
+        cerr << "Reading input from " << input << "..." << endl;
+        if (!strcmp(input.c_str(), "stdin")) {
             t.read_file("");
+        } else {
+            t.read_file(input);
+        }
+    }
+    if (!snapshot_out.empty()) {
+        cerr << "Writing snapshot to " << snapshot_out << "..." << endl;
+        t.write_snapshot(snapshot_out);
+    }
+    if (!seeds_in.empty()) {
+        cerr << "Reading seed sets from " << seeds_in << "..." << endl;
+        t.read_seeds(seeds_in);
+        cerr << "Calculating personalized pagerank..." << endl;
+        t.personalized_pagerank([&](size_t s) {
+            cerr << "Done calculating " << t.get_seed_set_name(s) << "! ("
+                 << t.get_num_iterations() << " iterations)" << endl;
+            cout << "# " << t.get_seed_set_name(s) << endl;
+            if (top > 0) {
+                t.print_pagerank_top(top);
+            } else {
+                t.print_pagerank_v();
+            }
+        });
+        return 0;
+    }
+    if (!local_seed.empty()) {
+        vector< pair<size_t, double> > ranks;
+        auto query = [&](const string &seed) {
+            auto start = chrono::steady_clock::now();
+            double unpushed = t.local_pagerank(seed, local_epsilon, top,
+                                               ranks);
+            chrono::duration<double, milli> elapsed =
+                chrono::steady_clock::now() - start;
+            if (ranks.empty() && unpushed == 0) {
+                cerr << "Vertex " << seed << " not in graph" << endl;
+                return;
+            }
+            cerr << "Done calculating " << seed << "! (" << t.get_num_pushes()
+                 << " pushes, " << elapsed.count() << " ms, error at most "
+                 << unpushed << ")" << endl;
+            t.print_pagerank_list(ranks);
+        };
+        if (local_seed != "-") {
+            query(local_seed);
+        } else {
+            string seed;
+            while (getline(cin, seed)) {
+                if (!seed.empty()) {
+                    cout << "# " << seed << endl;
+                    query(seed);
+                }
+            }
+        }
+        return 0;
+    }
+    if (!ordering.empty()) {
+        /* The time per iteration of a few iterations */
+        auto probe = [&]() {
+            unsigned long max_iterations = t.get_max_iterations();
+            t.set_max_iterations(REORDER_PROBE_ITERATIONS);
+            auto start = chrono::steady_clock::now();
+            t.pagerank();
+            chrono::duration<double, milli> elapsed =
+                chrono::steady_clock::now() - start;
+            t.set_max_iterations(max_iterations);
+            return elapsed.count() / max(t.get_num_iterations(), 1UL);
+        };
+        double before_ms = (walks == 0) ? probe() : 0;
+        cerr << "Reordering vertices by " << ordering << "..." << endl;
+        auto start = chrono::steady_clock::now();
+        t.reorder(ordering);
+        chrono::duration<double, milli> elapsed =
+            chrono::steady_clock::now() - start;
+        cerr << "Done reordering! (" << elapsed.count() << " ms)" << endl;
+        if (walks == 0) {
+            double after_ms = probe();
+            cerr << "Iterations take " << after_ms << " ms against "
+                 << before_ms << " ms before reordering";
+            if (after_ms < before_ms) {
+                cerr << "; reordering pays off after "
+                     << ceil(elapsed.count() / (before_ms - after_ms))
+                     << " iterations" << endl;
+            } else {
+                cerr << "; reordering does not pay off" << endl;
+            }
+        }
+    }
+    if (!start_in.empty()) {
+        cerr << "Reading starting pagerank from " << start_in << "..."
+             << endl;
+        t.read_pagerank(start_in);
+    }
+    if (walks > 0) {
+        cerr << "Estimating pagerank with " << walks << " walks per vertex..."
+             << endl;
+        t.monte_carlo_pagerank(walks);
+        cerr << "Done estimating! (" << t.get_num_steps() << " steps)"
+             << endl;
     } else {
-        t.read_file(input);
+        cerr << "Calculating pagerank..." << endl;
+        t.pagerank();
+        cerr << "Done calculating! (" << t.get_num_iterations()
+             << " iterations)" << endl;
+        const vector<size_t> &active = t.get_active_sizes();
+        if (t.get_adaptive_tolerance() > 0) {
+            cerr << "Active vertices per iteration:";
+            for (size_t k = 0; k < active.size(); k++) {
+                cerr << " " << active[k];
+            }
+            cerr << endl;
+        } else if (t.get_skip_trivial()) {
+            cerr << "Skipped " << t.get_num_unreferenced()
+                 << " vertices without incoming links and "
+                 << t.get_num_dangling() << " dangling vertices" << endl;
+        }
+    }
+    const vector< pair<unsigned long, double> > &savings =
+        t.get_extrapolation_savings();
+    for (size_t k = 0; k < savings.size(); k++) {
+        cerr << "Extrapolation after iteration " << savings[k].first
+             << " saved " << savings[k].second << " power iterations"
+             << endl;
+    }
+    if (!deltas_in.empty()) {
+        istream *deltas = &cin;
+        if (deltas_in != "-") {
+            deltas = new ifstream(deltas_in.c_str());
+            if (!*deltas) {
+                cerr << "Cannot open file " << deltas_in << endl;
+                exit(1);
+            }
+        }
+        unsigned long num_batches = 0;
+        while (t.read_delta(*deltas)) {
+            t.update_pagerank();
+            num_batches++;
+            cerr << "Updated pagerank for batch " << num_batches << " ("
+                 << t.get_num_pushes() << " pushes, error at most "
+                 << t.get_error_bound() << ")" << endl;
+        }
+        if (deltas != &cin) {
+            delete deltas;
+        }
+    }
+    if (!serve_socket.empty()) {
+        /* Interrupts are taken by a thread of their own, which stops the
+           server so that it removes its socket before exiting */
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+        Server server(t);
+        server.listen(serve_socket);
+        thread interrupts([&]() {
+            int signal;
+            sigwait(&signals, &signal);
+            server.stop();
+        });
+        cerr << "Serving requests on " << serve_socket << "..." << endl;
+        server.run();
+        kill(getpid(), SIGTERM);
+        interrupts.join();
+        return 0;
     }
-    cerr << "Calculating pagerank..." << endl;
-    t.pagerank();
-    cerr << "Done calculating!" << endl;
-    t.print_pagerank_v();
+    output();
 }
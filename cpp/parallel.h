@@ -0,0 +1,177 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+/*
+ * Threads kept waiting between the calls of run_parallel(), so that the
+ * iterations and phases of a calculation do not start and join threads
+ * every time. Each process has one pool; a child forked from a process
+ * with a pool gets a new one, as the threads of the old one do not
+ * exist in it. The pool runs one task at a time.
+ */
+class ThreadPool {
+
+private:
+
+    std::mutex run_mutex; // held while a task runs on the pool
+    std::mutex state_mutex; // guards the members below
+    std::condition_variable task_started;
+    std::condition_variable task_finished;
+    std::vector<std::thread> threads; // threads 1, 2, ... of the tasks
+    const std::function<void(unsigned int)> *task;
+    unsigned int num_threads; // threads of the current task
+    unsigned int num_pending; // threads yet to finish the current task
+    unsigned long generation; // number of tasks started
+
+    ThreadPool()
+        : task(nullptr),
+          num_threads(0),
+          num_pending(0),
+          generation(0) {
+    }
+
+    /* Whether the calling thread is running a task of the pool */
+    static bool &in_pool() {
+        static thread_local bool pooled = false;
+        return pooled;
+    }
+
+    /* Runs thread t of each task started after the given generation */
+    void work(unsigned int t, unsigned long seen) {
+
+        in_pool() = true;
+        std::unique_lock<std::mutex> lock(state_mutex);
+        while (true) {
+            task_started.wait(lock, [&]() { return generation != seen; });
+            seen = generation;
+            if (t >= num_threads) {
+                continue;
+            }
+            lock.unlock();
+            (*task)(t);
+            lock.lock();
+            if (--num_pending == 0) {
+                task_finished.notify_one();
+            }
+        }
+    }
+
+public:
+
+    /*
+     * Returns the pool of the calling process. It is never destroyed,
+     * so that its waiting threads need not be joined at exit.
+     */
+    static ThreadPool &get() {
+        static std::mutex pool_mutex;
+        static ThreadPool *pool = nullptr;
+        static pid_t pool_pid = 0;
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (pool == nullptr || pool_pid != getpid()) {
+            pool = new ThreadPool();
+            pool_pid = getpid();
+        }
+        return *pool;
+    }
+
+    /*
+     * Runs task(t) for t = 0, ..., n - 1 and returns when all of them
+     * have finished; task(0) runs on the calling thread. The pool grows
+     * to the largest n asked for. A task started while another runs on
+     * the pool, or from within one, gets threads of its own instead.
+     */
+    void run(unsigned int n, const std::function<void(unsigned int)> &fn) {
+
+        std::unique_lock<std::mutex> running(run_mutex, std::defer_lock);
+        if (in_pool() || !running.try_lock()) {
+            std::vector<std::thread> own;
+            for (unsigned int t = 1; t < n; t++) {
+                own.push_back(std::thread(fn, t));
+            }
+            fn(0);
+            for (size_t t = 0; t < own.size(); t++) {
+                own[t].join();
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            while (threads.size() + 1 < n) {
+                threads.push_back(std::thread(&ThreadPool::work, this,
+                                              threads.size() + 1,
+                                              generation));
+            }
+            task = &fn;
+            num_threads = n;
+            num_pending = n - 1;
+            generation++;
+        }
+        task_started.notify_all();
+        in_pool() = true;
+        fn(0);
+        in_pool() = false;
+        std::unique_lock<std::mutex> lock(state_mutex);
+        task_finished.wait(lock, [&]() { return num_pending == 0; });
+    }
+};
+
+/*
+ * Runs task(t) for t = 0, ..., num_threads - 1, each on its own
+ * thread of the pool, and returns when all of them have finished.
+ * task(0) runs on the calling thread, so with a single thread no other
+ * thread is involved.
+ */
+template <class Task>
+void run_parallel(unsigned int num_threads, Task task) {
+
+    if (num_threads <= 1) {
+        task(0);
+        return;
+    }
+    ThreadPool::get().run(num_threads,
+                          std::function<void(unsigned int)>(task));
+}
+
+#endif
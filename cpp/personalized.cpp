@@ -0,0 +1,248 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+
+#include "personalized.h"
+#include "parallel.h"
+
+template <class Index, class Value>
+void personalized_iterate(const Csr<Index> &in_rows,
+                          const vector< vector<size_t> > &seed_sets,
+                          const IterationSettings &settings,
+                          vector<double> &pr,
+                          const function<void(size_t,
+                                              unsigned long)> &done) {
+
+    const size_t W = SEED_BLOCK;
+    const size_t NO_SET = (size_t) -1;
+    size_t num_rows = in_rows.num_rows();
+    const vector<size_t> &row_offsets = in_rows.offsets;
+    const vector<Index> &cols = in_rows.cols;
+    const vector<double> &inv_outgoing = in_rows.inv_outgoing;
+    double alpha = settings.alpha;
+    unsigned int num_threads = settings.num_threads;
+
+    /*
+     * The interleaved pagerank vectors and the shares passed along each
+     * outgoing link, as in Table::power_iterate(); element i * W + j
+     * belongs to vertex i and lane j. The previous, normalised, value of
+     * each element is only needed when its row is calculated, so it is
+     * not kept, except for the seeds.
+     */
+    vector<Value> cur_pr(num_rows * W);
+    vector<Value> out_pr(num_rows * W);
+    vector<Value> seed_old_pr[W];
+
+    /* Per block and lane sums of the vectors, their dangling part and diff */
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    vector<double> block_sum(num_blocks * W);
+    vector<double> block_dangling(num_blocks * W);
+    vector<double> block_diff(num_blocks * W);
+    vector<size_t> bounds;
+    partition_rows(row_offsets, bounds, num_threads);
+
+    /* The set in each lane, its iterations, sum and dangling sum */
+    size_t lane_set[W];
+    unsigned long lane_iterations[W];
+    double lane_sum[W];
+    double lane_dangling[W];
+    size_t next_set = 0;
+    size_t num_active = 0;
+
+    /*
+     * Starts the next set with vertices in the graph in lane j, from its
+     * teleportation vector, or leaves the lane empty if there is none.
+     */
+    auto load = [&](size_t j) {
+        for (size_t i = 0; i < num_rows; i++) {
+            cur_pr[i * W + j] = 0;
+        }
+        lane_set[j] = NO_SET;
+        lane_iterations[j] = 0;
+        lane_sum[j] = 0;
+        lane_dangling[j] = 0;
+        while (next_set < seed_sets.size() && seed_sets[next_set].empty()) {
+            next_set++;
+        }
+        if (next_set == seed_sets.size()) {
+            return;
+        }
+        const vector<size_t> &seeds = seed_sets[next_set];
+        for (size_t k = 0; k < seeds.size(); k++) {
+            cur_pr[seeds[k] * W + j] = 1.0 / seeds.size();
+            if (in_rows.dangling(seeds[k])) {
+                lane_dangling[j] += 1.0 / seeds.size();
+            }
+        }
+        lane_sum[j] = 1;
+        lane_set[j] = next_set++;
+        num_active++;
+    };
+    for (size_t j = 0; j < W; j++) {
+        load(j);
+    }
+
+    while (num_active > 0) {
+
+        /* Normalize so that each vector starts with sum equal to one */
+        double scale[W];
+        for (size_t j = 0; j < W; j++) {
+            scale[j] = (lane_set[j] != NO_SET) ? 1 / lane_sum[j] : 0;
+        }
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+            size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+            for (size_t i = first; i < last; i++) {
+                for (size_t j = 0; j < W; j++) {
+                    out_pr[i * W + j] =
+                        inv_outgoing[i] * (cur_pr[i * W + j] * scale[j]);
+                }
+            }
+        });
+        for (size_t j = 0; j < W; j++) {
+            seed_old_pr[j].clear();
+            if (lane_set[j] != NO_SET) {
+                const vector<size_t> &seeds = seed_sets[lane_set[j]];
+                for (size_t k = 0; k < seeds.size(); k++) {
+                    seed_old_pr[j].push_back(
+                        cur_pr[seeds[k] * W + j] * scale[j]);
+                }
+            }
+        }
+
+        /* The H multiplication, for all lanes at once */
+        run_parallel(num_threads, [&](unsigned int t) {
+            for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+                size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+                double b_diff[W] = { 0 }, b_sum[W] = { 0 };
+                double b_dangling[W] = { 0 };
+                for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                    double h[W] = { 0 };
+                    const Index *ci; // current incoming
+                    const Index *row_end = cols.data() + row_offsets[i + 1];
+                    for (ci = cols.data() + row_offsets[i]; ci != row_end;
+                         ci++) {
+                        const Value *out = out_pr.data() + *ci * W;
+                        for (size_t j = 0; j < W; j++) {
+                            h[j] += out[j];
+                        }
+                    }
+                    for (size_t j = 0; j < W; j++) {
+                        Value old = cur_pr[i * W + j] * scale[j];
+                        Value v = alpha * h[j];
+                        cur_pr[i * W + j] = v;
+                        b_diff[j] += fabs(v - old);
+                        b_sum[j] += v;
+                    }
+                    if (in_rows.dangling(i)) {
+                        for (size_t j = 0; j < W; j++) {
+                            b_dangling[j] += cur_pr[i * W + j];
+                        }
+                    }
+                }
+                for (size_t j = 0; j < W; j++) {
+                    block_diff[b * W + j] = b_diff[j];
+                    block_sum[b * W + j] = b_sum[j];
+                    block_dangling[b * W + j] = b_dangling[j];
+                }
+            }
+        });
+
+        for (size_t j = 0; j < W; j++) {
+            if (lane_set[j] == NO_SET) {
+                continue;
+            }
+            double diff = 0, sum = 0, dangling = 0;
+            for (size_t b = 0; b < num_blocks; b++) {
+                diff += block_diff[b * W + j];
+                sum += block_sum[b * W + j];
+                dangling += block_dangling[b * W + j];
+            }
+
+            /*
+             * Teleportation and the dangling mass go to the seeds; the
+             * sums are corrected for the seeds' new values.
+             */
+            const vector<size_t> &seeds = seed_sets[lane_set[j]];
+            double teleport = (alpha * lane_dangling[j] * scale[j]
+                               + (1 - alpha)) / seeds.size();
+            for (size_t k = 0; k < seeds.size(); k++) {
+                size_t e = seeds[k] * W + j;
+                Value old = seed_old_pr[j][k];
+                Value v = cur_pr[e] + teleport;
+                diff += fabs(v - old) - fabs(cur_pr[e] - old);
+                sum += v - cur_pr[e];
+                if (in_rows.dangling(seeds[k])) {
+                    dangling += v - cur_pr[e];
+                }
+                cur_pr[e] = v;
+            }
+            lane_sum[j] = sum;
+            lane_dangling[j] = dangling;
+            lane_iterations[j]++;
+
+            if (diff <= settings.convergence
+                || lane_iterations[j] >= settings.max_iterations) {
+                pr.resize(num_rows);
+                for (size_t i = 0; i < num_rows; i++) {
+                    pr[i] = cur_pr[i * W + j];
+                }
+                num_active--;
+                done(lane_set[j], lane_iterations[j]);
+                load(j);
+            }
+        }
+    }
+}
+
+template void personalized_iterate<uint32_t, float>(
+    const Csr<uint32_t> &, const vector< vector<size_t> > &,
+    const IterationSettings &, vector<double> &,
+    const function<void(size_t, unsigned long)> &);
+
+template void personalized_iterate<uint32_t, double>(
+    const Csr<uint32_t> &, const vector< vector<size_t> > &,
+    const IterationSettings &, vector<double> &,
+    const function<void(size_t, unsigned long)> &);
+
+template void personalized_iterate<uint64_t, float>(
+    const Csr<uint64_t> &, const vector< vector<size_t> > &,
+    const IterationSettings &, vector<double> &,
+    const function<void(size_t, unsigned long)> &);
+
+template void personalized_iterate<uint64_t, double>(
+    const Csr<uint64_t> &, const vector< vector<size_t> > &,
+    const IterationSettings &, vector<double> &,
+    const function<void(size_t, unsigned long)> &);
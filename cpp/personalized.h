@@ -0,0 +1,64 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PERSONALIZED_H
+#define PERSONALIZED_H
+
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+#include "csr.h"
+
+using namespace std;
+
+/* The number of personalized pagerank vectors iterated together */
+const size_t SEED_BLOCK = 8;
+
+/*
+ * Calculates the personalized pagerank of each of seed_sets, whose
+ * vertices are sorted and unique, on the graph whose incoming links are
+ * in_rows, as described in Table::personalized_pagerank(), with values
+ * of type Value. As each set s converges, its pagerank vector is left
+ * in pr and done(s, iterations) is called with the iterations it took.
+ */
+template <class Index, class Value>
+void personalized_iterate(const Csr<Index> &in_rows,
+                          const vector< vector<size_t> > &seed_sets,
+                          const IterationSettings &settings,
+                          vector<double> &pr,
+                          const function<void(size_t,
+                                              unsigned long)> &done);
+
+#endif
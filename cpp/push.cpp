@@ -0,0 +1,167 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <deque>
+
+#include "push.h"
+
+/*
+ * Flags of local_state: the vertex has been reached by the current
+ * query, and it is waiting to push its residual.
+ */
+const unsigned char LOCAL_TOUCHED = 1;
+const unsigned char LOCAL_QUEUED = 2;
+
+LocalPush::LocalPush()
+    : num_pushes(0) {
+}
+
+void LocalPush::clear() {
+    local_pr.clear();
+    local_residual.clear();
+    local_state.clear();
+}
+
+template <class Index>
+double LocalPush::push(const Csr<Index> &out_rows, double alpha,
+                       const vector<size_t> &seeds, double epsilon,
+                       size_t k, vector< pair<size_t, double> > &top) {
+
+    size_t num_rows = out_rows.num_rows();
+    const vector<size_t> &out_row_offsets = out_rows.offsets;
+    const vector<Index> &out_cols = out_rows.cols;
+    local_pr.resize(num_rows, 0);
+    local_residual.resize(num_rows, 0);
+    local_state.resize(num_rows, 0);
+
+    vector<size_t> touched; // the vertices to clear after the query
+    deque<size_t> work;
+    auto add = [&](size_t v, double r) {
+        if (!(local_state[v] & LOCAL_TOUCHED)) {
+            local_state[v] |= LOCAL_TOUCHED;
+            touched.push_back(v);
+        }
+        local_residual[v] += r;
+        if (!(local_state[v] & LOCAL_QUEUED)
+            && local_residual[v] > epsilon
+                * max<size_t>(out_row_offsets[v + 1] - out_row_offsets[v],
+                              1)) {
+            local_state[v] |= LOCAL_QUEUED;
+            work.push_back(v);
+        }
+    };
+
+    vector<size_t> valid;
+    for (size_t s = 0; s < seeds.size(); s++) {
+        if (seeds[s] < num_rows) {
+            valid.push_back(seeds[s]);
+        }
+    }
+    for (size_t s = 0; s < valid.size(); s++) {
+        add(valid[s], 1.0 / valid.size());
+    }
+
+    /*
+     * The mass pushed by dangling vertices is gathered and returned to
+     * the seeds when nothing else is left to push, as if by a vertex
+     * linking to all of them.
+     */
+    double dangling = 0;
+    num_pushes = 0;
+    while (true) {
+        if (work.empty()) {
+            if (dangling <= epsilon * valid.size()) {
+                break;
+            }
+            double share = dangling / valid.size();
+            dangling = 0;
+            for (size_t s = 0; s < valid.size(); s++) {
+                add(valid[s], share);
+            }
+            continue;
+        }
+        size_t u = work.front();
+        work.pop_front();
+        local_state[u] &= ~LOCAL_QUEUED;
+        double r = local_residual[u];
+        local_residual[u] = 0;
+        local_pr[u] += (1 - alpha) * r;
+        num_pushes++;
+        size_t first = out_row_offsets[u];
+        size_t last = out_row_offsets[u + 1];
+        if (first == last) {
+            dangling += alpha * r;
+            continue;
+        }
+        double share = alpha * r / (last - first);
+        for (size_t a = first; a < last; a++) {
+            add(out_cols[a], share);
+        }
+    }
+
+    /* Collect the ranks, and leave the scratch vectors zero */
+    double unpushed = dangling;
+    top.clear();
+    for (size_t t = 0; t < touched.size(); t++) {
+        size_t v = touched[t];
+        if (local_pr[v] > 0) {
+            top.push_back(make_pair(v, local_pr[v]));
+        }
+        unpushed += local_residual[v];
+        local_pr[v] = 0;
+        local_residual[v] = 0;
+        local_state[v] = 0;
+    }
+    auto before = [](const pair<size_t, double> &a,
+                     const pair<size_t, double> &b) {
+        return a.second > b.second
+            || (a.second == b.second && a.first < b.first);
+    };
+    k = (k == 0) ? top.size() : min(k, top.size());
+    partial_sort(top.begin(), top.begin() + k, top.end(), before);
+    top.resize(k);
+    return unpushed;
+}
+
+unsigned long LocalPush::get_num_pushes() const {
+    return num_pushes;
+}
+
+template double LocalPush::push(const Csr<uint32_t> &, double,
+                                const vector<size_t> &, double, size_t,
+                                vector< pair<size_t, double> > &);
+template double LocalPush::push(const Csr<uint64_t> &, double,
+                                const vector<size_t> &, double, size_t,
+                                vector< pair<size_t, double> > &);
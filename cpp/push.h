@@ -0,0 +1,87 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PUSH_H
+#define PUSH_H
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "csr.h"
+
+using namespace std;
+
+/*
+ * Answers the single source personalized pagerank queries of
+ * Table::local_pagerank() by pushing mass forward along the outgoing
+ * links of the graph. The scratch vectors are kept between queries, all
+ * zero, so that a query only touches the vertices it reaches.
+ */
+class LocalPush {
+private:
+
+    vector<double> local_pr; // approximate personalized pagerank
+    vector<double> local_residual; // mass not yet pushed
+    vector<unsigned char> local_state; // LOCAL_TOUCHED and LOCAL_QUEUED
+    unsigned long num_pushes; // pushes by the last query
+
+public:
+
+    LocalPush();
+
+    /*
+     * Frees the scratch vectors.
+     */
+    void clear();
+
+    /*
+     * Pushes residuals from seeds along the outgoing links in out_rows
+     * until none exceeds epsilon times the outdegree of its vertex, and
+     * fills top with the k vertices with the highest rank, or all those
+     * reached if k is 0, highest first; see Table::local_pagerank().
+     * Returns the mass left unpushed.
+     */
+    template <class Index>
+    double push(const Csr<Index> &out_rows, double alpha,
+                const vector<size_t> &seeds, double epsilon, size_t k,
+                vector< pair<size_t, double> > &top);
+
+    /*
+     * Returns the number of pushes performed by the last query.
+     */
+    unsigned long get_num_pushes() const;
+};
+
+#endif
@@ -0,0 +1,293 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+
+/* Bytes read from a connection at a time */
+const size_t REQUEST_CHUNK = 4096;
+
+/* Longest request accepted; longer ones close the connection */
+const size_t MAX_REQUEST_LENGTH = 65536;
+
+Server::Server(Table &t)
+    : table(t),
+      listen_fd(-1),
+      stopping(false) {
+    publish();
+}
+
+Server::~Server() {
+    stop();
+    if (listen_fd >= 0) {
+        close(listen_fd);
+    }
+}
+
+void Server::publish() {
+
+    shared_ptr<Ranking> r = make_shared<Ranking>();
+    r->alpha = table.get_alpha();
+    r->num_iterations = table.get_num_iterations();
+    r->pr = table.get_pagerank();
+
+    const vector<double> &pr = r->pr;
+    r->by_rank.resize(pr.size());
+    for (size_t k = 0; k < pr.size(); k++) {
+        r->by_rank[k] = k;
+    }
+    sort(r->by_rank.begin(), r->by_rank.end(), [&](size_t a, size_t b) {
+        return pr[a] > pr[b] || (pr[a] == pr[b] && a < b);
+    });
+
+    atomic_store(&ranking, shared_ptr<const Ranking>(r));
+}
+
+size_t Server::find_vertex(string_view name, size_t num_rows) {
+
+    if (table.get_numeric()) {
+        size_t index;
+        from_chars_result r = from_chars(name.data(),
+                                         name.data() + name.size(), index);
+        if (r.ec != errc() || r.ptr != name.data() + name.size()
+            || index >= num_rows) {
+            return Dictionary::npos;
+        }
+        return index;
+    }
+    size_t index = table.get_mapping().find(name);
+    return (index < num_rows) ? index : Dictionary::npos;
+}
+
+void Server::answer(string_view request, string &out) {
+
+    char num[32]; // enough for any size_t or double
+    char *num_end;
+
+    size_t space = request.find(' ');
+    string_view command = request.substr(0, space);
+    string_view argument = (space == string_view::npos)
+        ? string_view()
+        : request.substr(space + 1);
+
+    if (command == "RANK") {
+        shared_ptr<const Ranking> r = atomic_load(&ranking);
+        size_t index = find_vertex(argument, r->pr.size());
+        if (index == Dictionary::npos) {
+            out.append("ERROR unknown vertex\n");
+            return;
+        }
+        num_end = to_chars(num, num + sizeof(num), r->pr[index]).ptr;
+        out.append("OK ");
+        out.append(num, num_end - num);
+        out.push_back('\n');
+    } else if (command == "TOP") {
+        shared_ptr<const Ranking> r = atomic_load(&ranking);
+        size_t k;
+        from_chars_result fr = from_chars(argument.data(),
+                                          argument.data() + argument.size(),
+                                          k);
+        if (fr.ec != errc() || fr.ptr != argument.data() + argument.size()) {
+            out.append("ERROR invalid count\n");
+            return;
+        }
+        k = min(k, r->by_rank.size());
+        num_end = to_chars(num, num + sizeof(num), k).ptr;
+        out.append("OK ");
+        out.append(num, num_end - num);
+        out.push_back('\n');
+        for (size_t j = 0; j < k; j++) {
+            size_t index = r->by_rank[j];
+            out.append(table.get_node_name(index));
+            out.append(" = ");
+            num_end = to_chars(num, num + sizeof(num), r->pr[index]).ptr;
+            out.append(num, num_end - num);
+            out.push_back('\n');
+        }
+    } else if (command == "ALPHA") {
+        double alpha;
+        from_chars_result fr = from_chars(argument.data(),
+                                          argument.data() + argument.size(),
+                                          alpha);
+        if (fr.ec != errc() || fr.ptr != argument.data() + argument.size()
+            || !(alpha > 0 && alpha < 1)) {
+            out.append("ERROR invalid alpha\n");
+            return;
+        }
+        unsigned long num_iterations;
+        {
+            lock_guard<mutex> lock(calculate_mutex);
+            double old_alpha = table.get_alpha();
+            table.set_alpha(alpha);
+            string failure = table.try_pagerank();
+            if (!failure.empty()) {
+                /* The old results are still served */
+                table.set_alpha(old_alpha);
+                out.append("ERROR ");
+                out.append(failure);
+                out.push_back('\n');
+                return;
+            }
+            num_iterations = table.get_num_iterations();
+            publish();
+        }
+        num_end = to_chars(num, num + sizeof(num), num_iterations).ptr;
+        out.append("OK ");
+        out.append(num, num_end - num);
+        out.push_back('\n');
+    } else {
+        out.append("ERROR unknown request\n");
+    }
+}
+
+void Server::serve_connection(int fd) {
+
+    string requests; // received, but not yet complete, requests
+    string replies;
+    char chunk[REQUEST_CHUNK];
+
+    while (true) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            break;
+        }
+        requests.append(chunk, n);
+
+        /* All the complete requests received are answered at once */
+        replies.clear();
+        size_t start = 0, eol;
+        while ((eol = requests.find('\n', start)) != string::npos) {
+            string_view request(requests.data() + start, eol - start);
+            if (!request.empty() && request.back() == '\r') {
+                request.remove_suffix(1);
+            }
+            answer(request, replies);
+            start = eol + 1;
+        }
+        requests.erase(0, start);
+
+        const char *p = replies.data();
+        const char *end = p + replies.size();
+        while (p < end) {
+            ssize_t sent = send(fd, p, end - p, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                break;
+            }
+            p += sent;
+        }
+        if (p < end || requests.size() > MAX_REQUEST_LENGTH) {
+            break;
+        }
+    }
+
+    lock_guard<mutex> lock(connections_mutex);
+    connection_fds.erase(fd);
+    close(fd);
+    connections_done.notify_all();
+}
+
+void Server::listen(const string &socket_path) {
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        table.error("Socket path too long", socket_path.c_str());
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+
+    /* Only a socket left by an earlier server is replaced */
+    struct stat st;
+    if (stat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(socket_path.c_str());
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0
+        || bind(listen_fd, (const sockaddr *) &addr, sizeof(addr)) < 0
+        || ::listen(listen_fd, SOMAXCONN) < 0) {
+        table.error("Cannot listen on socket", socket_path.c_str());
+    }
+    path = socket_path;
+}
+
+void Server::run() {
+
+    while (true) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        lock_guard<mutex> lock(connections_mutex);
+        if (stopping) {
+            close(fd);
+            break;
+        }
+        connection_fds.insert(fd);
+        thread(&Server::serve_connection, this, fd).detach();
+    }
+
+    unique_lock<mutex> lock(connections_mutex);
+    connections_done.wait(lock, [&]() { return connection_fds.empty(); });
+}
+
+void Server::stop() {
+
+    lock_guard<mutex> lock(connections_mutex);
+    if (stopping || listen_fd < 0) {
+        return;
+    }
+    stopping = true;
+
+    /* Wakes up run(), and the connections waiting for requests */
+    shutdown(listen_fd, SHUT_RDWR);
+    for (set<int>::iterator fd = connection_fds.begin();
+         fd != connection_fds.end(); fd++) {
+        shutdown(*fd, SHUT_RDWR);
+    }
+    unlink(path.c_str());
+}
@@ -0,0 +1,150 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+
+#include "table.h"
+
+using namespace std;
+
+/*
+ * A server that keeps a graph and its pagerank in memory and answers
+ * requests about them over a Unix domain socket. Each request is a
+ * line, and its reply starts with a line that begins with OK, followed
+ * by the answer, or with ERROR, followed by the reason:
+ *
+ *   RANK name   the pagerank of the named vertex; OK value
+ *   TOP k       the k vertices with the highest pagerank, highest
+ *               first; OK count, followed by count lines of the form
+ *               name = value
+ *   ALPHA a     recalculates the pagerank with damping factor a, between
+ *               0 and 1, and replies once the new results are served;
+ *               OK iterations
+ *
+ * Each connection is served by a thread of its own, and requests sent
+ * one after the other on a connection are answered in order; a
+ * connection is closed if a request grows too long. The
+ * results are kept in an immutable ranking, which requests read
+ * without locking; a recalculation builds a new ranking and swaps it
+ * in atomically, so requests on other connections are answered from
+ * the old one until then. Only one recalculation runs at a time.
+ */
+class Server {
+
+private:
+
+    /*
+     * The results served: the pagerank of each vertex and the vertices
+     * sorted by it, highest first, with ties in index order.
+     */
+    struct Ranking {
+        double alpha;
+        unsigned long num_iterations;
+        vector<double> pr;
+        vector<size_t> by_rank;
+    };
+
+    Table &table;
+    shared_ptr<const Ranking> ranking; // loaded and stored atomically
+    mutex calculate_mutex; // held while the table recalculates
+    int listen_fd; // the listening socket, or -1
+    string path; // where the listening socket is bound
+    mutex connections_mutex; // guards the members below
+    condition_variable connections_done; // signalled as connections end
+    set<int> connection_fds; // the sockets of the open connections
+    bool stopping; // stop() has been called
+
+    /*
+     * Makes a ranking of the current pagerank of the table and serves
+     * it from then on.
+     */
+    void publish();
+
+    /*
+     * Answers the requests read from the connection fd until it is
+     * closed, and then closes it.
+     */
+    void serve_connection(int fd);
+
+    /*
+     * Appends the reply to request to out.
+     */
+    void answer(string_view request, string &out);
+
+    /*
+     * Returns the index of the vertex with the given name among the
+     * num_rows vertices, or Dictionary::npos if there is none.
+     */
+    size_t find_vertex(string_view name, size_t num_rows);
+
+public:
+
+    /*
+     * Serves the pagerank already calculated by t, which must not be
+     * used otherwise while the server runs.
+     */
+    Server(Table &t);
+
+    ~Server();
+
+    /*
+     * Binds the server to a Unix domain socket at the given path,
+     * replacing a socket left there, and listens on it.
+     */
+    void listen(const string &socket_path);
+
+    /*
+     * Accepts connections and serves each in a thread of its own, until
+     * stop() is called; then returns once all the connections are
+     * closed.
+     */
+    void run();
+
+    /*
+     * Stops the server: closes its listening socket and its
+     * connections, and removes the socket file.
+     */
+    void stop();
+};
+
+#endif
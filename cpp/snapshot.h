@@ -0,0 +1,147 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+ 
+   All rights reserved.
+  
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ 
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ 
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+ 
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <ostream>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+#include <unistd.h>
+
+/*
+ * Helpers for the binary snapshot format of Table. A snapshot is a
+ * sequence of sections, each holding the raw contents of an array and
+ * padded with zeros to a multiple of SECTION_ALIGN bytes, so that every
+ * section starts aligned in a memory mapped snapshot.
+ */
+
+const size_t SECTION_ALIGN = 8;
+
+/*
+ * Writes the contents of v as a section to out.
+ */
+template <class T>
+void write_section(std::ostream &out, const std::vector<T> &v) {
+
+    static const char padding[SECTION_ALIGN] = { 0 };
+    size_t bytes = v.size() * sizeof(T);
+
+    out.write((const char *) v.data(), bytes);
+    out.write(padding, (SECTION_ALIGN - bytes % SECTION_ALIGN) % SECTION_ALIGN);
+}
+
+/*
+ * Reads a section of count elements, starting at p, into v, and
+ * advances p past the section. Returns false, leaving v and p as they
+ * were, if the section would extend beyond end.
+ */
+template <class T>
+bool read_section(const char *&p, const char *end, std::vector<T> &v,
+                  size_t count) {
+
+    size_t bytes = count * sizeof(T);
+    size_t padded = (bytes + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+
+    if (count > (size_t) (end - p) / sizeof(T) || padded > (size_t) (end - p)) {
+        return false;
+    }
+    v.resize(count);
+    memcpy(v.data(), p, bytes);
+    p += padded;
+    return true;
+}
+
+/*
+ * Advances p past a section of count elements of type T, without
+ * reading it. Returns false, leaving p as it was, if the section would
+ * extend beyond end.
+ */
+template <class T>
+bool skip_section(const char *&p, const char *end, size_t count) {
+
+    size_t bytes = count * sizeof(T);
+    size_t padded = (bytes + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+
+    if (count > (size_t) (end - p) / sizeof(T) || padded > (size_t) (end - p)) {
+        return false;
+    }
+    p += padded;
+    return true;
+}
+
+/*
+ * Reads bytes bytes at position pos of the file open in fd into dst.
+ * Returns false if they cannot all be read.
+ */
+inline bool read_at(int fd, uint64_t pos, void *dst, size_t bytes) {
+
+    char *p = (char *) dst;
+    while (bytes > 0) {
+        ssize_t n = pread(fd, p, bytes, pos);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        pos += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+/*
+ * Reads a section of count elements, starting at p in the mapping at
+ * start of the file open in fd, into v, like read_section(), but with
+ * read_at() instead of copying from the mapping, so that its pages are
+ * not held by the process along with v.
+ */
+template <class T>
+bool load_section(int fd, const char *start, const char *&p,
+                  const char *end, std::vector<T> &v, size_t count) {
+
+    const char *section = p;
+    if (!skip_section<T>(p, end, count)) {
+        return false;
+    }
+    v.resize(count);
+    if (!read_at(fd, section - start, v.data(), count * sizeof(T))) {
+        p = section;
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,255 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/*
+ * Helpers for the worker processes of Table, which are connected in
+ * pairs by stream sockets. In every round of messages each process
+ * sends a message to each of the others and receives one from each, all
+ * at once, so that no pair of processes waits for another to read its
+ * messages. Independently started workers find each other through
+ * socket addresses, which are either host:port, for TCP, or the path of
+ * a Unix domain socket.
+ */
+
+/*
+ * Returns true if address is a TCP one, host:port.
+ */
+inline bool tcp_address(const std::string &address) {
+
+    size_t colon = address.rfind(':');
+    return colon != std::string::npos && colon > 0
+        && colon + 1 < address.size()
+        && address.find_first_not_of("0123456789", colon + 1)
+           == std::string::npos;
+}
+
+/*
+ * Fills addr with the socket address given by address, looking up its
+ * host if it is a TCP one, and sets len to its length. Returns false if
+ * the address is invalid or its host cannot be found.
+ */
+inline bool socket_address(const std::string &address, sockaddr_storage &addr,
+                           socklen_t &len) {
+
+    memset(&addr, 0, sizeof(addr));
+    if (!tcp_address(address)) {
+        sockaddr_un *un = (sockaddr_un *) &addr;
+        if (address.empty() || address.size() >= sizeof(un->sun_path)) {
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, address.c_str());
+        len = sizeof(sockaddr_un);
+        return true;
+    }
+
+    size_t colon = address.rfind(':');
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *found;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+        return false;
+    }
+    memcpy(&addr, found->ai_addr, found->ai_addrlen);
+    len = found->ai_addrlen;
+    freeaddrinfo(found);
+    return true;
+}
+
+/*
+ * Returns a socket listening on address, or -1 if there cannot be one.
+ * Only a Unix domain socket left by an earlier process is replaced.
+ */
+inline int listen_socket(const std::string &address) {
+
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!socket_address(address, addr, len)) {
+        return -1;
+    }
+    if (addr.ss_family == AF_UNIX) {
+        struct stat st;
+        if (stat(address.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(address.c_str());
+        }
+    }
+
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    int on = 1;
+    if (fd >= 0 && addr.ss_family != AF_UNIX) {
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+    if (fd < 0 || bind(fd, (const sockaddr *) &addr, len) < 0
+        || listen(fd, SOMAXCONN) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Returns a socket connected to address, or -1 if nothing listens on it
+ * yet or it is invalid.
+ */
+inline int connect_socket(const std::string &address) {
+
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!socket_address(address, addr, len)) {
+        return -1;
+    }
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (const sockaddr *) &addr, len) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Returns the TCP address, as host:port, of the local end of the socket
+ * fd, with the given port instead of its own unless port is empty, or
+ * an empty string if it has none.
+ */
+inline std::string local_address(int fd, const std::string &port = "") {
+
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    char host[NI_MAXHOST], serv[NI_MAXSERV];
+    if (getsockname(fd, (sockaddr *) &addr, &len) < 0
+        || addr.ss_family == AF_UNIX
+        || getnameinfo((const sockaddr *) &addr, len, host, sizeof(host),
+                       serv, sizeof(serv), NI_NUMERICHOST | NI_NUMERICSERV)
+           != 0) {
+        return "";
+    }
+    return std::string(host) + ":" + ((port.empty()) ? serv : port);
+}
+
+/*
+ * Sends out[p] on fds[p] and receives in[p].size() bytes from fds[p]
+ * into in[p], for every p with fds[p] >= 0, all at once. Returns false
+ * if any of the connections fails or is closed before its message has
+ * been received.
+ */
+inline bool exchange(const std::vector<int> &fds,
+                     const std::vector< std::vector<char> > &out,
+                     std::vector< std::vector<char> > &in) {
+
+    size_t num_peers = fds.size();
+    std::vector<size_t> sent(num_peers, 0), received(num_peers, 0);
+    std::vector<pollfd> polled;
+    std::vector<size_t> peers; // the peer of each element of polled
+
+    while (true) {
+        polled.clear();
+        peers.clear();
+        for (size_t p = 0; p < num_peers; p++) {
+            short events = 0;
+            if (fds[p] < 0) {
+                continue;
+            }
+            if (sent[p] < out[p].size()) {
+                events |= POLLOUT;
+            }
+            if (received[p] < in[p].size()) {
+                events |= POLLIN;
+            }
+            if (events) {
+                pollfd pfd = { fds[p], events, 0 };
+                polled.push_back(pfd);
+                peers.push_back(p);
+            }
+        }
+        if (polled.empty()) {
+            return true;
+        }
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        for (size_t k = 0; k < polled.size(); k++) {
+            size_t p = peers[k];
+            short revents = polled[k].revents;
+            if (revents & (POLLERR | POLLNVAL)) {
+                return false;
+            }
+            if (revents & POLLOUT) {
+                ssize_t n = send(fds[p], out[p].data() + sent[p],
+                                 out[p].size() - sent[p],
+                                 MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n >= 0) {
+                    sent[p] += n;
+                } else if (errno != EAGAIN && errno != EINTR) {
+                    return false;
+                }
+            }
+            if (revents & (POLLIN | POLLHUP)) {
+                ssize_t n = recv(fds[p], in[p].data() + received[p],
+                                 in[p].size() - received[p], MSG_DONTWAIT);
+                if (n > 0) {
+                    received[p] += n;
+                } else if (n == 0
+                           || (errno != EAGAIN && errno != EINTR)) {
+                    return false;
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,433 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <math.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stream.h"
+#include "parallel.h"
+#include "snapshot.h"
+
+/*
+ * Bytes of column indices read at a time when streaming the rows of a
+ * snapshot, rounded up to whole blocks of rows, and row offsets read at
+ * a time.
+ */
+const size_t STREAM_CHUNK_BYTES = 64 << 20;
+const size_t STREAM_OFFSETS = 1 << 20;
+
+bool write_run(vector< pair<size_t, size_t> > &arcs, const string &filename) {
+
+    sort(arcs.begin(), arcs.end(),
+         [](const pair<size_t, size_t> &a, const pair<size_t, size_t> &b) {
+             return a.second < b.second
+                 || (a.second == b.second && a.first < b.first);
+         });
+    arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+
+    ofstream out(filename.c_str(), ios::binary);
+    if (!out) {
+        return false;
+    }
+    out.write((const char *) arcs.data(),
+              arcs.size() * sizeof(pair<size_t, size_t>));
+    out.close();
+    arcs.clear();
+    return (bool) out;
+}
+
+template <class Index>
+bool merge_runs(const vector<string> &runs, ostream &out,
+                vector<size_t> &row_offsets, vector<size_t> &num_outgoing,
+                size_t &num_arcs) {
+
+    typedef pair<size_t, size_t> Arc;
+    const size_t RUN_BUFFER = 1 << 16; // arcs read from each run at a time
+    const size_t OUT_BUFFER = 1 << 20; // column indices written at a time
+
+    size_t num_runs = runs.size();
+    vector<ifstream> files(num_runs);
+    vector< vector<Arc> > buffers(num_runs);
+    vector<size_t> pos(num_runs, 0);
+
+    /* Refills the buffer of run r; returns false at its end */
+    auto refill = [&](size_t r) {
+        buffers[r].resize(RUN_BUFFER);
+        files[r].read((char *) buffers[r].data(), RUN_BUFFER * sizeof(Arc));
+        buffers[r].resize(files[r].gcount() / sizeof(Arc));
+        pos[r] = 0;
+        return !buffers[r].empty();
+    };
+
+    /* The next arc of each run, smallest destination and source first */
+    typedef pair<Arc, size_t> Head;
+    auto after = [](const Head &a, const Head &b) {
+        return a.first.second > b.first.second
+            || (a.first.second == b.first.second
+                && a.first.first > b.first.first);
+    };
+    priority_queue<Head, vector<Head>, decltype(after)> heads(after);
+    for (size_t r = 0; r < num_runs; r++) {
+        files[r].open(runs[r].c_str(), ios::binary);
+        if (!files[r]) {
+            return false;
+        }
+        if (refill(r)) {
+            heads.push(Head(buffers[r][0], r));
+        }
+    }
+
+    num_outgoing.assign(num_outgoing.size(), 0);
+    vector<Index> cols;
+    cols.reserve(OUT_BUFFER);
+    num_arcs = 0;
+    bool first = true;
+    Arc last;
+    while (!heads.empty()) {
+        Head h = heads.top();
+        heads.pop();
+        size_t r = h.second;
+        if (++pos[r] < buffers[r].size() || refill(r)) {
+            heads.push(Head(buffers[r][pos[r]], r));
+        }
+        /* The same arc may come from more than one run */
+        if (!first && h.first == last) {
+            continue;
+        }
+        first = false;
+        last = h.first;
+        row_offsets[last.second + 1]++;
+        num_outgoing[last.first]++;
+        cols.push_back(last.first);
+        num_arcs++;
+        if (cols.size() == OUT_BUFFER) {
+            out.write((const char *) cols.data(), cols.size() * sizeof(Index));
+            cols.clear();
+        }
+    }
+    out.write((const char *) cols.data(), cols.size() * sizeof(Index));
+
+    static const char padding[SECTION_ALIGN] = { 0 };
+    size_t bytes = num_arcs * sizeof(Index);
+    out.write(padding, (SECTION_ALIGN - bytes % SECTION_ALIGN) % SECTION_ALIGN);
+
+    return true;
+}
+
+template <class Index>
+bool stream_rows(const StreamedRows &rows, int fd,
+                 const function<void(size_t, size_t, const size_t *,
+                                     const Index *)> &process) {
+
+    size_t num_rows = rows.num_rows;
+
+    /*
+     * Two chunks: the reader fills one while the other is processed.
+     * The indices of the chunks move between the two queues.
+     */
+    struct Chunk {
+        size_t first_row;
+        vector<size_t> offsets;
+        vector<Index> cols;
+    };
+    Chunk chunks[2];
+    deque<size_t> filled;
+    deque<size_t> empty = { 0, 1 };
+    bool done = false;
+    bool failed = false;
+    mutex m;
+    condition_variable cv;
+
+    thread reader([&]() {
+        /* The row offsets are read ahead too, in their own buffer */
+        vector<size_t> offsets(STREAM_OFFSETS);
+        size_t offsets_pos = 0, offsets_len = 0, offsets_read = 0;
+        auto next_offset = [&](size_t &offset) {
+            if (offsets_pos == offsets_len) {
+                offsets_len = min(STREAM_OFFSETS, num_rows + 1 - offsets_read);
+                if (!read_at(fd, rows.offsets_pos
+                             + offsets_read * sizeof(size_t),
+                             offsets.data(), offsets_len * sizeof(size_t))) {
+                    return false;
+                }
+                offsets_read += offsets_len;
+                offsets_pos = 0;
+            }
+            offset = offsets[offsets_pos++];
+            return true;
+        };
+
+        size_t row = 0;
+        size_t start;
+        bool ok = next_offset(start);
+        while (ok && row < num_rows) {
+            size_t k;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&]() { return !empty.empty(); });
+                k = empty.front();
+                empty.pop_front();
+            }
+            Chunk &c = chunks[k];
+            c.first_row = row;
+            c.offsets.assign(1, start);
+            while (ok && row < num_rows && (c.offsets.back() - start)
+                   * sizeof(Index) < STREAM_CHUNK_BYTES) {
+                size_t last = min(row + BLOCK_ROWS, num_rows);
+                for (; ok && row < last; row++) {
+                    size_t offset;
+                    ok = next_offset(offset)
+                        && offset >= c.offsets.back();
+                    c.offsets.push_back(offset);
+                }
+            }
+            if (!ok) {
+                break;
+            }
+            c.cols.resize(c.offsets.back() - start);
+            ok = read_at(fd, rows.cols_pos + start * sizeof(Index),
+                         c.cols.data(), c.cols.size() * sizeof(Index));
+            if (!ok) {
+                break;
+            }
+            start = c.offsets.back();
+            {
+                lock_guard<mutex> lock(m);
+                filled.push_back(k);
+            }
+            cv.notify_all();
+        }
+        {
+            lock_guard<mutex> lock(m);
+            failed = !ok;
+            done = true;
+        }
+        cv.notify_all();
+    });
+
+    while (true) {
+        size_t k;
+        {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]() { return !filled.empty() || done; });
+            if (filled.empty()) {
+                break;
+            }
+            k = filled.front();
+            filled.pop_front();
+        }
+        Chunk &c = chunks[k];
+        process(c.first_row, c.offsets.size() - 1, c.offsets.data(),
+                c.cols.data());
+        {
+            lock_guard<mutex> lock(m);
+            empty.push_back(k);
+        }
+        cv.notify_all();
+    }
+    reader.join();
+
+    return !failed;
+}
+
+template <class Index, class Value>
+bool stream_iterate(const StreamedRows &rows,
+                    const vector<double> &inv_outgoing,
+                    const IterationSettings &settings, vector<double> &pr,
+                    const function<void(unsigned long,
+                                        const vector<double> &)> &trace,
+                    unsigned long &num_iterations) {
+
+    double diff = 1;
+    double sum_pr; // sum of current pagerank vector elements
+    double dangling_pr; // sum of current pagerank vector elements for dangling
+                        // nodes
+    size_t num_rows = rows.num_rows;
+    double alpha = settings.alpha;
+    unsigned int num_threads = settings.num_threads;
+
+    int fd = open(rows.filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    /*
+     * The pagerank vector and its previous, normalised, value; the share
+     * passed along each outgoing link is calculated as in
+     * Table::power_iterate(), but when it is used, to save a vector.
+     */
+    vector<Value> cur_pr(pr.begin(), pr.end());
+    vector<Value> old_pr(num_rows);
+    vector<double>().swap(pr);
+
+    /* Per block sums of the pagerank vector, its dangling part and diff */
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    vector<double> block_sum(num_blocks);
+    vector<double> block_dangling(num_blocks);
+    vector<double> block_diff(num_blocks);
+
+    for (size_t k = 0; k < num_rows; k++) {
+        block_sum[k / BLOCK_ROWS] += cur_pr[k];
+        if (inv_outgoing[k] == 0) {
+            block_dangling[k / BLOCK_ROWS] += cur_pr[k];
+        }
+    }
+
+    bool ok = true;
+    num_iterations = 0;
+    while (diff > settings.convergence
+           && num_iterations < settings.max_iterations) {
+
+        sum_pr = 0;
+        dangling_pr = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            sum_pr += block_sum[b];
+            dangling_pr += block_dangling[b];
+        }
+
+        /*
+         * Normalize so that we start with sum equal to one; the initial
+         * vector is used as is.
+         */
+        for (size_t i = 0; i < num_rows; i++) {
+            old_pr[i] = (num_iterations == 0)
+                ? cur_pr[i]
+                : cur_pr[i] / sum_pr;
+        }
+        sum_pr = 1;
+
+        double one_Av = alpha * dangling_pr / num_rows;
+        double one_Iv = (1 - alpha) * sum_pr / num_rows;
+
+        /* The blocks of each chunk are split among the threads */
+        ok = stream_rows<Index>(rows, fd, [&](size_t first_row,
+                                              size_t chunk_rows,
+                                              const size_t *offsets,
+                                              const Index *cols) {
+            size_t first_block = first_row / BLOCK_ROWS;
+            size_t chunk_blocks = (chunk_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+            run_parallel(num_threads, [&](unsigned int t) {
+                size_t b_first = first_block + chunk_blocks * t / num_threads;
+                size_t b_last = first_block
+                    + chunk_blocks * (t + 1) / num_threads;
+                for (size_t b = b_first; b < b_last; b++) {
+                    size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+                    double b_diff = 0, b_sum = 0, b_dangling = 0;
+                    for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                        double h = 0.0;
+                        const Index *ci = cols
+                            + (offsets[i - first_row] - offsets[0]);
+                        const Index *row_end = cols
+                            + (offsets[i - first_row + 1] - offsets[0]);
+                        for (; ci != row_end; ci++) {
+                            h += (Value) (inv_outgoing[*ci] * old_pr[*ci]);
+                        }
+                        h *= alpha;
+                        cur_pr[i] = h + one_Av + one_Iv;
+                        b_diff += fabs(cur_pr[i] - old_pr[i]);
+                        b_sum += cur_pr[i];
+                        if (inv_outgoing[i] == 0) {
+                            b_dangling += cur_pr[i];
+                        }
+                    }
+                    block_diff[b] = b_diff;
+                    block_sum[b] = b_sum;
+                    block_dangling[b] = b_dangling;
+                }
+            });
+        });
+        if (!ok) {
+            break;
+        }
+
+        /* The difference to be checked for convergence */
+        diff = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            diff += block_diff[b];
+        }
+        num_iterations++;
+        if (trace) {
+            pr.assign(cur_pr.begin(), cur_pr.end());
+            trace(num_iterations, pr);
+        }
+    }
+
+    close(fd);
+
+    pr.assign(cur_pr.begin(), cur_pr.end());
+    return ok;
+}
+
+template bool merge_runs<uint32_t>(const vector<string> &, ostream &,
+                                   vector<size_t> &, vector<size_t> &,
+                                   size_t &);
+template bool merge_runs<uint64_t>(const vector<string> &, ostream &,
+                                   vector<size_t> &, vector<size_t> &,
+                                   size_t &);
+template bool stream_rows<uint32_t>(
+    const StreamedRows &, int,
+    const function<void(size_t, size_t, const size_t *, const uint32_t *)> &);
+template bool stream_rows<uint64_t>(
+    const StreamedRows &, int,
+    const function<void(size_t, size_t, const size_t *, const uint64_t *)> &);
+template bool stream_iterate<uint32_t, float>(
+    const StreamedRows &, const vector<double> &, const IterationSettings &,
+    vector<double> &,
+    const function<void(unsigned long, const vector<double> &)> &,
+    unsigned long &);
+template bool stream_iterate<uint32_t, double>(
+    const StreamedRows &, const vector<double> &, const IterationSettings &,
+    vector<double> &,
+    const function<void(unsigned long, const vector<double> &)> &,
+    unsigned long &);
+template bool stream_iterate<uint64_t, float>(
+    const StreamedRows &, const vector<double> &, const IterationSettings &,
+    vector<double> &,
+    const function<void(unsigned long, const vector<double> &)> &,
+    unsigned long &);
+template bool stream_iterate<uint64_t, double>(
+    const StreamedRows &, const vector<double> &, const IterationSettings &,
+    vector<double> &,
+    const function<void(unsigned long, const vector<double> &)> &,
+    unsigned long &);
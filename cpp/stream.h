@@ -0,0 +1,120 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <functional>
+#include <utility>
+#include <stdint.h>
+
+#include "csr.h"
+
+using namespace std;
+
+/*
+ * The external sort that builds snapshots of graphs whose arcs do not
+ * fit in memory, and the semi-external power method that streams the
+ * rows of a snapshot from disk, for Table::build_snapshot() and
+ * Table::open_snapshot().
+ */
+
+/*
+ * Where the rows of a snapshot file are: its number of rows and the
+ * file positions of its row offsets, column indices and number of
+ * outgoing links sections (see snapshot.h).
+ */
+struct StreamedRows {
+    string filename;
+    size_t num_rows;
+    uint64_t offsets_pos;
+    uint64_t cols_pos;
+    uint64_t outgoing_pos;
+};
+
+/*
+ * Sorts the (from, to) arcs by destination and then source, drops their
+ * duplicates, and writes them to the run file filename, emptying arcs.
+ * Returns false if the file cannot be written.
+ */
+bool write_run(vector< pair<size_t, size_t> > &arcs, const string &filename);
+
+/*
+ * Merges the sorted runs into the column indices section of a snapshot
+ * being written to out, and counts the incoming arcs of each row r
+ * into row_offsets[r + 1] and the outgoing ones of each vertex into
+ * num_outgoing, both already sized for all the vertices. Leaves the
+ * number of unique arcs in num_arcs. Returns false if a run cannot be
+ * read.
+ */
+template <class Index>
+bool merge_runs(const vector<string> &runs, ostream &out,
+                vector<size_t> &row_offsets, vector<size_t> &num_outgoing,
+                size_t &num_arcs);
+
+/*
+ * Reads rows from the snapshot open in fd in chunks of whole blocks,
+ * and calls process(first_row, num_rows, offsets, cols) for each in
+ * turn; offsets holds the num_rows + 1 offsets of the rows of the
+ * chunk, and cols their column indices, starting at offsets[0]. A
+ * reader thread reads the next chunk while the current one is
+ * processed. Returns false if the file cannot be read or its row
+ * offsets are invalid.
+ */
+template <class Index>
+bool stream_rows(const StreamedRows &rows, int fd,
+                 const function<void(size_t, size_t, const size_t *,
+                                     const Index *)> &process);
+
+/*
+ * Performs the power iterations of Table::pagerank() on the rows
+ * streamed from the snapshot, with the calculations carried out on
+ * values of type Value, starting from pr and leaving the results in it.
+ * Only the pagerank vectors are kept in memory besides inv_outgoing.
+ * Calls trace(iteration, pr), if given, after every iteration, and
+ * leaves the number of iterations in num_iterations. Returns false if
+ * the rows cannot be read.
+ */
+template <class Index, class Value>
+bool stream_iterate(const StreamedRows &rows,
+                    const vector<double> &inv_outgoing,
+                    const IterationSettings &settings, vector<double> &pr,
+                    const function<void(unsigned long,
+                                        const vector<double> &)> &trace,
+                    unsigned long &num_iterations);
+
+#endif
@@ -42,15 +42,120 @@
 #include <string>
 #include <cstring>
 #include <limits>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "table.h"
+#include "csr.h"
+#include "parallel.h"
+#include "snapshot.h"
+
+/*
+ * Number of consecutive vertices formatted by each thread at a time
+ * when outputting the pagerank vector.
+ */
+const size_t OUTPUT_CHUNK = 65536;
+
+/*
+ * The header of a snapshot file. It is followed by sections (see
+ * snapshot.h) holding, in order, the row offsets, the column indices
+ * and the number of outgoing links of each vertex and, in string mode,
+ * the dictionary of names.
+ */
+struct SnapshotHeader {
+    char magic[8]; // SNAPSHOT_MAGIC
+    uint32_t version; // SNAPSHOT_VERSION
+    uint32_t byte_order; // SNAPSHOT_BYTE_ORDER, as stored by the writer
+    uint32_t flags; // SNAPSHOT_NUMERIC, SNAPSHOT_WIDE_INDICES
+    uint32_t index_bytes; // size of each column index
+    uint64_t num_rows;
+    uint64_t num_arcs;
+};
+
+const char SNAPSHOT_MAGIC[8] = { 'P', 'R', 'S', 'N', 'A', 'P', '\0', '\0' };
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+const uint32_t SNAPSHOT_NUMERIC = 1;
+const uint32_t SNAPSHOT_WIDE_INDICES = 2;
+
+/*
+ * Reads the header of the snapshot starting at p into header, and
+ * advances p past it. Returns false if there is no valid header before
+ * end.
+ */
+static bool read_header(const char *&p, const char *end,
+                        SnapshotHeader &header) {
+
+    if ((size_t) (end - p) < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    bool wide = (header.flags & SNAPSHOT_WIDE_INDICES) != 0;
+    return memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+        && header.version == SNAPSHOT_VERSION
+        && header.byte_order == SNAPSHOT_BYTE_ORDER
+        && header.index_bytes == ((wide)
+                                  ? sizeof(uint64_t)
+                                  : sizeof(uint32_t));
+}
+
+/*
+ * The number of vertices last placed by the Gorder ordering whose
+ * neighbours it scores; the authors found 5 to work best.
+ */
+const size_t GORDER_WINDOW = 5;
+
+/*
+ * The most outgoing links of a vertex through which the Gorder ordering
+ * counts shared incoming neighbours; every vertex placed costs the
+ * square of the links of each of its incoming neighbours counted.
+ */
+const size_t GORDER_MAX_SIBLINGS = 64;
+
+/*
+ * The adaptive power method compacts its worklist again when fewer than
+ * this share of the vertices in it are still active.
+ */
+const double ADAPTIVE_COMPACTION = 0.9;
+
+/*
+ * The adaptive power method divides its tolerance by this each time it
+ * thaws the frozen vertices.
+ */
+const double ADAPTIVE_TIGHTENING = 10;
 
 void Table::reset() {
     num_outgoing.clear();
-    rows.clear();
-    nodes_to_idx.clear();
-    idx_to_nodes.clear();
+    arcs.clear();
+    finalized = false;
+    wide_indices = false;
+    row_offsets.clear();
+    col_indices.clear();
+    wide_col_indices.clear();
+    inv_outgoing.clear();
+    names.clear();
     pr.clear();
+    start_pr.clear();
+    delta_arcs.clear();
+    out_row_offsets.clear();
+    out_col_indices.clear();
+    wide_out_col_indices.clear();
+    incremental.clear();
+    seed_set_names.clear();
+    seed_sets.clear();
+    seed_set_index.clear();
+    local_push.clear();
+    stream_filename.clear();
+    order.clear();
 }
 
 Table::Table(double a, double c, size_t i, bool t, bool n, string d)
@@ -59,21 +164,51 @@ Table::Table(double a, double c, size_t i, bool t, bool n, string d)
       convergence(c),
       max_iterations(i),
       delim(d),
-      numeric(n) {
+      numeric(n),
+      num_threads(DEFAULT_NUM_THREADS),
+      num_processes(DEFAULT_NUM_PROCESSES),
+      worker(0),
+      single_precision(DEFAULT_SINGLE_PRECISION),
+      force_wide_indices(false),
+      solver(SOLVER_POWER),
+      num_iterations(0),
+      num_steps(0),
+      bin_width(DEFAULT_BIN_WIDTH),
+      skip_trivial(false),
+      adaptive_tolerance(DEFAULT_ADAPTIVE_TOLERANCE),
+      num_unreferenced(0),
+      num_dangling(0),
+      extrapolation(EXTRAPOLATION_NONE),
+      extrapolation_period(DEFAULT_EXTRAPOLATION_PERIOD),
+      finalized(false),
+      wide_indices(false),
+      run_arcs(DEFAULT_RUN_ARCS),
+      stream_offsets_pos(0),
+      stream_cols_pos(0),
+      stream_outgoing_pos(0),
+      num_pushes(0) {
 }
 
 void Table::reserve(size_t size) {
     num_outgoing.reserve(size);
-    rows.reserve(size);
+    row_offsets.reserve(size + 1);
 }
 
 const size_t Table::get_num_rows() {
-    return rows.size();
+    return num_outgoing.size();
+}
+
+const size_t Table::get_num_arcs() {
+    return row_offsets.empty() ? 0 : row_offsets.back();
 }
 
 void Table::set_num_rows(size_t num_rows) {
     num_outgoing.resize(num_rows);
-    rows.resize(num_rows);
+    if (finalized) {
+        /* New rows are empty; they start where the last row ends */
+        row_offsets.resize(num_rows + 1, row_offsets.back());
+        inv_outgoing.resize(num_rows);
+    }
 }
 
 const void Table::error(const char *p,const char *p2) {
@@ -115,12 +250,168 @@ const string Table::get_node_name(size_t index) {
         s << index;
         return s.str();
     } else {
-        return idx_to_nodes[index];
+        return string(names.name(index));
+    }
+}
+
+const Dictionary& Table::get_mapping() {
+    return names;
+}
+
+const unsigned int Table::get_num_threads() {
+    return num_threads;
+}
+
+void Table::set_num_threads(unsigned int n) {
+    num_threads = (n) ? n : 1;
+}
+
+const unsigned int Table::get_num_processes() {
+    return num_processes;
+}
+
+void Table::set_num_processes(unsigned int n) {
+    num_processes = (n) ? n : 1;
+}
+
+const unsigned int Table::get_worker() {
+    return worker;
+}
+
+void Table::set_worker(unsigned int w, const string &address) {
+    worker = w;
+    rendezvous = address;
+}
+
+const bool Table::get_single_precision() {
+    return single_precision;
+}
+
+void Table::set_single_precision(bool s) {
+    single_precision = s;
+}
+
+const bool Table::get_streamed() {
+    return !stream_filename.empty();
+}
+
+const size_t Table::get_run_arcs() {
+    return run_arcs;
+}
+
+void Table::set_run_arcs(size_t n) {
+    run_arcs = (n) ? n : 1;
+}
+
+const bool Table::get_wide_indices() {
+    return wide_indices;
+}
+
+void Table::set_force_wide_indices(bool w) {
+    force_wide_indices = w;
+}
+
+const Solver Table::get_solver() {
+    return solver;
+}
+
+void Table::set_solver(Solver s) {
+    solver = s;
+}
+
+const char *Table::get_solver_name() {
+    return SOLVER_NAMES[solver];
+}
+
+bool Table::set_solver(const string &name) {
+    for (int s = 0; s < NUM_SOLVERS; s++) {
+        if (name == SOLVER_NAMES[s]) {
+            solver = (Solver) s;
+            return true;
+        }
+    }
+    return false;
+}
+
+const unsigned long Table::get_num_iterations() {
+    return num_iterations;
+}
+
+const vector< pair<unsigned long, double> > &
+Table::get_extrapolation_savings() {
+    return extrapolation_savings;
+}
+
+const Extrapolation Table::get_extrapolation() {
+    return extrapolation;
+}
+
+const char *Table::get_extrapolation_name() {
+    return EXTRAPOLATION_NAMES[extrapolation];
+}
+
+void Table::set_extrapolation(Extrapolation e) {
+    extrapolation = e;
+}
+
+bool Table::set_extrapolation(const string &name) {
+    for (int e = 0; e < NUM_EXTRAPOLATIONS; e++) {
+        if (name == EXTRAPOLATION_NAMES[e]) {
+            extrapolation = (Extrapolation) e;
+            return true;
+        }
+    }
+    return false;
+}
+
+const size_t Table::get_bin_width() {
+    return bin_width;
+}
+
+void Table::set_bin_width(size_t w) {
+    bin_width = 0;
+    if (w > 0) {
+        bin_width = BLOCK_ROWS;
+        while (bin_width < w) {
+            bin_width *= 2;
+        }
     }
 }
 
-const map<size_t, string>& Table::get_mapping() {
-    return idx_to_nodes;
+const bool Table::get_skip_trivial() {
+    return skip_trivial;
+}
+
+void Table::set_skip_trivial(bool s) {
+    skip_trivial = s;
+}
+
+const double Table::get_adaptive_tolerance() {
+    return adaptive_tolerance;
+}
+
+void Table::set_adaptive_tolerance(double t) {
+    adaptive_tolerance = t;
+}
+
+const vector<size_t> &Table::get_active_sizes() {
+    return active_sizes;
+}
+
+const size_t Table::get_num_unreferenced() {
+    return num_unreferenced;
+}
+
+const size_t Table::get_num_dangling() {
+    return num_dangling;
+}
+
+const unsigned long Table::get_extrapolation_period() {
+    return extrapolation_period;
+}
+
+void Table::set_extrapolation_period(unsigned long p) {
+    extrapolation_period = p;
 }
 
 const bool Table::get_trace() {
@@ -147,302 +438,3110 @@ void Table::set_delim(string d) {
     delim = d;
 }
 
-/*
- * From a blog post at: http://bit.ly/1QQ3hv
- */
-void Table::trim(string &str) {
+string_view Table::trim(string_view str) {
 
     size_t startpos = str.find_first_not_of(" \t");
 
-    if (string::npos == startpos) {
-        str = "";
+    if (string_view::npos == startpos) {
+        return string_view();
     } else {
-        str = str.substr(startpos, str.find_last_not_of(" \t") - startpos + 1);
+        return str.substr(startpos,
+                          str.find_last_not_of(" \t") - startpos + 1);
     }
 }
 
-size_t Table::insert_mapping(const string &key) {
+size_t Table::parse_index(string_view str) {
 
+    const char *p = str.data();
+    const char *end = p + str.size();
+    bool negative = false;
     size_t index = 0;
-    map<string, size_t>::const_iterator i = nodes_to_idx.find(key);
-    if (i != nodes_to_idx.end()) {
-        index = i->second;
-    } else {
-        index = nodes_to_idx.size();
-        nodes_to_idx.insert(pair<string, size_t>(key, index));
-        idx_to_nodes.insert(pair<size_t, string>(index, key));;
+
+    while (p != end && isspace((unsigned char) *p)) {
+        p++;
+    }
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    while (p != end && *p >= '0' && *p <= '9') {
+        index = index * 10 + (*p - '0');
+        p++;
     }
 
-    return index;
+    return (negative) ? -index : index;
 }
 
-int Table::read_file(const string &filename) {
-
-    pair<map<string, size_t>::iterator, bool> ret;
-
-    reset();
-    
-    istream *infile;
-
-    if (filename.empty()) {
-      infile = &cin;
-    } else {
-      infile = new ifstream(filename.c_str());
-      if (!infile) {
-          error("Cannot open file", filename.c_str());
-      }
-    }
-    
-    size_t delim_len = delim.length();
-    size_t linenum = 0;
-    string line; // current line
-    while (getline(*infile, line)) {
-        string from, to; // from and to fields
-        size_t from_idx, to_idx; // indices of from and to nodes
-        size_t pos = line.find(delim);
-        if (pos != string::npos) {
-            from = line.substr(0, pos);
-            trim(from);
-            if (!numeric) {
-                from_idx = insert_mapping(from);
-            } else {
-                from_idx = strtol(from.c_str(), NULL, 10);
-            }
-            to = line.substr(pos + delim_len);
-            trim(to);
-            if (!numeric) {
-                to_idx = insert_mapping(to);
-            } else {
-                to_idx = strtol(to.c_str(), NULL, 10);
-            }
-            add_arc(from_idx, to_idx);
-        }
+size_t Table::insert_mapping(string_view key) {
+    return names.insert(key);
+}
 
-        linenum++;
-        if (linenum && ((linenum % 100000) == 0)) {
-            cerr << "read " << linenum << " lines, "
-                 << rows.size() << " vertices" << endl;
-        }
+bool Table::split_line(string_view line, string_view &from, string_view &to) {
 
-        from.clear();
-        to.clear();
-        line.clear();
+    size_t pos = line.find(delim);
+    if (pos == string_view::npos) {
+        return false;
     }
+    from = trim(line.substr(0, pos));
+    to = trim(line.substr(pos + delim.length()));
+    return true;
+}
 
-    cerr << "read " << linenum << " lines, "
-         << rows.size() << " vertices" << endl;
-
-    nodes_to_idx.clear();
+void Table::read_line(string_view line) {
 
-    if (infile != &cin) {
-        delete infile;
+    size_t from_idx, to_idx; // indices of from and to nodes
+    string_view from, to; // from and to fields
+    if (split_line(line, from, to)) {
+        if (!numeric) {
+            from_idx = insert_mapping(from);
+            to_idx = insert_mapping(to);
+        } else {
+            from_idx = parse_index(from);
+            to_idx = parse_index(to);
+        }
+        add_arc(from_idx, to_idx);
     }
-    reserve(idx_to_nodes.size());
-    
-    return 0;
 }
 
-/*
- * Taken from: M. H. Austern, "Why You Shouldn't Use set - and What You Should
- * Use Instead", C++ Report 12:4, April 2000.
- */
-template <class Vector, class T>
-bool Table::insert_into_vector(Vector& v, const T& t) {
-    typename Vector::iterator i = lower_bound(v.begin(), v.end(), t);
-    if (i == v.end() || t < *i) {
-        v.insert(i, t);
-        return true;
-    } else {
-        return false;
+size_t Table::read_chunks(const char *data, size_t size) {
+
+    const char *end = data + size;
+    unsigned int n = num_threads;
+
+    /*
+     * Split the data in about equal chunks; each line belongs to the
+     * chunk in which it starts.
+     */
+    vector<const char *> starts(n + 1, end);
+    starts[0] = data;
+    for (unsigned int t = 1; t < n; t++) {
+        size_t pos = size / n * t + size % n * t / n;
+        const char *eol = (pos == 0)
+            ? data - 1
+            : (const char *) memchr(data + pos - 1, '\n', size - pos + 1);
+        starts[t] = (eol != NULL) ? max(eol + 1, starts[t - 1]) : end;
     }
-}
 
-bool Table::add_arc(size_t from, size_t to) {
-
-    bool ret = false;
-    size_t max_dim = max(from, to);
-    if (trace) {
-        cout << "checking to add " << from << " => " << to << endl;
+    /*
+     * Count the lines of each chunk, so that each thread can put the arcs
+     * it reads directly in its own part of the arc buffer.
+     */
+    vector<size_t> line_offsets(n + 1, 0);
+    run_parallel(n, [&](unsigned int t) {
+        size_t lines = count(starts[t], starts[t + 1], '\n');
+        if (starts[t] != starts[t + 1] && *(starts[t + 1] - 1) != '\n') {
+            lines++;
+        }
+        line_offsets[t + 1] = lines;
+    });
+    for (unsigned int t = 0; t < n; t++) {
+        line_offsets[t + 1] += line_offsets[t];
     }
-    if (rows.size() <= max_dim) {
-        max_dim = max_dim + 1;
-        if (trace) {
-            cout << "resizing rows from " << rows.size() << " to "
-                 << max_dim << endl;
+    arcs.resize(line_offsets[n]);
+
+    /*
+     * Parse the chunks. In string mode each thread maps the names it
+     * meets to local indices, in order of first appearance, and keeps
+     * the names themselves as views into the data.
+     */
+    vector<size_t> chunk_arcs(n, 0);
+    vector<size_t> chunk_rows(n, 0);
+    vector< vector<string_view> > chunk_names(n);
+    atomic<size_t> lines_read(0);
+    atomic<size_t> vertices_read(0);
+    mutex report_mutex;
+    run_parallel(n, [&](unsigned int t) {
+        unordered_map<string_view, size_t> local_idx;
+        vector<string_view> &names = chunk_names[t];
+        pair<size_t, size_t> *out = arcs.data() + line_offsets[t];
+        size_t num_arcs = 0, num_rows = 0, linenum = 0, reported = 0;
+        auto local_mapping = [&](string_view key) {
+            pair<unordered_map<string_view, size_t>::iterator, bool> ret =
+                local_idx.insert(make_pair(key, names.size()));
+            if (ret.second) {
+                names.push_back(key);
+            }
+            return ret.first->second;
+        };
+        const char *p = starts[t];
+        while (p < starts[t + 1]) {
+            const char *eol =
+                (const char *) memchr(p, '\n', starts[t + 1] - p);
+            if (eol == NULL) {
+                eol = starts[t + 1];
+            }
+            string_view from, to; // from and to fields
+            if (split_line(string_view(p, eol - p), from, to)) {
+                size_t from_idx, to_idx; // indices of from and to nodes
+                if (!numeric) {
+                    from_idx = local_mapping(from);
+                    to_idx = local_mapping(to);
+                } else {
+                    from_idx = parse_index(from);
+                    to_idx = parse_index(to);
+                    num_rows = max(num_rows, max(from_idx, to_idx) + 1);
+                }
+                out[num_arcs++] = pair<size_t, size_t>(from_idx, to_idx);
+            }
+            p = eol + 1;
+
+            linenum++;
+            if ((linenum % 100000) == 0) {
+                /*
+                 * In string mode names read by more than one thread are
+                 * counted more than once until the chunks are merged.
+                 */
+                size_t vertices;
+                if (!numeric) {
+                    vertices = (vertices_read += names.size() - reported);
+                    reported = names.size();
+                } else {
+                    vertices = vertices_read;
+                    while (vertices < num_rows
+                           && !vertices_read.compare_exchange_weak(vertices,
+                                                                   num_rows));
+                    vertices = max(vertices, num_rows);
+                }
+                size_t lines = (lines_read += 100000);
+                lock_guard<mutex> lock(report_mutex);
+                cerr << "read " << lines << " lines, "
+                     << vertices << " vertices" << endl;
+            }
         }
-        rows.resize(max_dim);
-        if (num_outgoing.size() <= max_dim) {
-            num_outgoing.resize(max_dim);
+        chunk_arcs[t] = num_arcs;
+        chunk_rows[t] = num_rows;
+    });
+
+    /*
+     * Merge the local names in chunk order, which assigns the same
+     * indices as reading the file sequentially, and translate the arcs
+     * of each chunk to them.
+     */
+    if (!numeric) {
+        vector< vector<size_t> > to_global(n);
+        for (unsigned int t = 0; t < n; t++) {
+            to_global[t].resize(chunk_names[t].size());
+            for (size_t k = 0; k < chunk_names[t].size(); k++) {
+                to_global[t][k] = insert_mapping(chunk_names[t][k]);
+            }
+            chunk_rows[t] = names.size();
         }
+        run_parallel(n, [&](unsigned int t) {
+            pair<size_t, size_t> *out = arcs.data() + line_offsets[t];
+            for (size_t k = 0; k < chunk_arcs[t]; k++) {
+                out[k].first = to_global[t][out[k].first];
+                out[k].second = to_global[t][out[k].second];
+            }
+        });
     }
 
-    ret = insert_into_vector(rows[to], from);
-
-    if (ret) {
-        num_outgoing[from]++;
-        if (trace) {
-            cout << "added " << from << " => " << to << endl;
-        }
+    /* Close the gaps left by lines without arcs */
+    size_t num_arcs = 0;
+    size_t num_rows = 0;
+    for (unsigned int t = 0; t < n; t++) {
+        copy(arcs.begin() + line_offsets[t],
+             arcs.begin() + line_offsets[t] + chunk_arcs[t],
+             arcs.begin() + num_arcs);
+        num_arcs += chunk_arcs[t];
+        num_rows = max(num_rows, chunk_rows[t]);
+    }
+    arcs.resize(num_arcs);
+    if (num_outgoing.size() < num_rows) {
+        num_outgoing.resize(num_rows);
     }
 
-    return ret;
+    return line_offsets[n];
 }
 
-void Table::pagerank() {
-
-    vector<size_t>::iterator ci; // current incoming
-    double diff = 1;
-    size_t i;
-    double sum_pr; // sum of current pagerank vector elements
-    double dangling_pr; // sum of current pagerank vector elements for dangling
-    			// nodes
-    unsigned long num_iterations = 0;
-    vector<double> old_pr;
+int Table::read_file(const string &filename) {
 
-    size_t num_rows = rows.size();
-    
-    if (num_rows == 0) {
-        return;
-    }
-    
-    pr.resize(num_rows);
+    reset();
 
-    pr[0] = 1;
+    int fd = -1;
+    struct stat st;
+    const char *data = NULL; // the mapped input file
 
-    if (trace) {
-        print_pagerank();
+    if (!filename.empty()) {
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error("Cannot open file", filename.c_str());
+        }
+        /* Regular, non-empty files are mapped; anything else is streamed */
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data = (const char *) addr;
+                madvise(addr, st.st_size, MADV_SEQUENTIAL);
+            }
+        }
     }
-    
-    while (diff > convergence && num_iterations < max_iterations) {
 
-        sum_pr = 0;
-        dangling_pr = 0;
-        
-        for (size_t k = 0; k < pr.size(); k++) {
-            double cpr = pr[k];
-            sum_pr += cpr;
-            if (num_outgoing[k] == 0) {
-                dangling_pr += cpr;
+    size_t linenum = 0;
+    if (data != NULL && num_threads > 1 && !trace) {
+        linenum = read_chunks(data, st.st_size);
+        munmap((void *) data, st.st_size);
+    } else if (data != NULL) {
+        const char *p = data;
+        const char *end = data + st.st_size;
+        while (p < end) {
+            const char *eol = (const char *) memchr(p, '\n', end - p);
+            if (eol == NULL) {
+                eol = end;
             }
-        }
+            read_line(string_view(p, eol - p));
+            p = eol + 1;
 
-        if (num_iterations == 0) {
-            old_pr = pr;
-        } else {
-            /* Normalize so that we start with sum equal to one */
-            for (i = 0; i < pr.size(); i++) {
-                old_pr[i] = pr[i] / sum_pr;
+            linenum++;
+            if ((linenum % 100000) == 0) {
+                cerr << "read " << linenum << " lines, "
+                     << num_outgoing.size() << " vertices" << endl;
             }
         }
-
-        /*
-         * After normalisation the elements of the pagerank vector sum
-         * to one
-         */
-        sum_pr = 1;
-        
-        /* An element of the A x I vector; all elements are identical */
-        double one_Av = alpha * dangling_pr / num_rows;
-
-        /* An element of the 1 x I vector; all elements are identical */
-        double one_Iv = (1 - alpha) * sum_pr / num_rows;
-
-        /* The difference to be checked for convergence */
-        diff = 0;
-        for (i = 0; i < num_rows; i++) {
-            /* The corresponding element of the H multiplication */
-            double h = 0.0;
-            for (ci = rows[i].begin(); ci != rows[i].end(); ci++) {
-                /* The current element of the H vector */
-                double h_v = (num_outgoing[*ci])
-                    ? 1.0 / num_outgoing[*ci]
-                    : 0.0;
-                if (num_iterations == 0 && trace) {
-                    cout << "h[" << i << "," << *ci << "]=" << h_v << endl;
-                }
-                h += h_v * old_pr[*ci];
+        munmap((void *) data, st.st_size);
+    } else {
+        istream *infile = &cin;
+        if (fd >= 0) {
+            infile = new ifstream(filename.c_str());
+        }
+        string line; // current line
+        while (getline(*infile, line)) {
+            read_line(line);
+
+            linenum++;
+            if ((linenum % 100000) == 0) {
+                cerr << "read " << linenum << " lines, "
+                     << num_outgoing.size() << " vertices" << endl;
             }
-            h *= alpha;
-            pr[i] = h + one_Av + one_Iv;
-            diff += fabs(pr[i] - old_pr[i]);
         }
-        num_iterations++;
-        if (trace) {
-            cout << num_iterations << ": ";
-            print_pagerank();
+        if (infile != &cin) {
+            delete infile;
         }
     }
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    cerr << "read " << linenum << " lines, "
+         << num_outgoing.size() << " vertices" << endl;
+
+    finalize();
     
+    return 0;
 }
 
-const void Table::print_params(ostream& out) {
-    out << "alpha = " << alpha << " convergence = " << convergence
-        << " max_iterations = " << max_iterations
-        << " numeric = " << numeric
-        << " delimiter = '" << delim << "'" << endl;
-}
+int Table::write_snapshot(const string &filename) {
 
-const void Table::print_table() {
-    vector< vector<size_t> >::iterator cr;
-    vector<size_t>::iterator cc; // current column
+    finalize();
 
-    size_t i = 0;
-    for (cr = rows.begin(); cr != rows.end(); cr++) {
-        cout << i << ":[ ";
-        for (cc = cr->begin(); cc != cr->end(); cc++) {
-            if (numeric) {
-                cout << *cc << " ";
-            } else {
-                cout << idx_to_nodes[*cc] << " ";
-            }
-        }
-        cout << "]" << endl;
-        i++;
+    if (!stream_filename.empty()) {
+        error("Cannot write a snapshot of a streamed graph");
+    }
+    if (!order.empty()) {
+        error("Cannot write a snapshot of a reordered graph");
     }
-}
 
-const void Table::print_outgoing() {
-    vector<size_t>::iterator cn;
+    ofstream out(filename.c_str(), ios::binary);
+    if (!out) {
+        error("Cannot open file", filename.c_str());
+    }
 
-    cout << "[ ";
-    for (cn = num_outgoing.begin(); cn != num_outgoing.end(); cn++) {
-        cout << *cn << " ";
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.flags = ((numeric) ? SNAPSHOT_NUMERIC : 0)
+        | ((wide_indices) ? SNAPSHOT_WIDE_INDICES : 0);
+    header.index_bytes = (wide_indices) ? sizeof(uint64_t) : sizeof(uint32_t);
+    header.num_rows = num_outgoing.size();
+    header.num_arcs = row_offsets.back();
+    out.write((const char *) &header, sizeof(header));
+
+    write_section(out, row_offsets);
+    if (wide_indices) {
+        write_section(out, wide_col_indices);
+    } else {
+        write_section(out, col_indices);
+    }
+    write_section(out, num_outgoing);
+    if (!numeric) {
+        names.write(out);
+    }
+
+    out.close();
+    if (!out) {
+        error("Cannot write file", filename.c_str());
     }
-    cout << "]" << endl;
 
+    return 0;
 }
 
-const void Table::print_pagerank() {
+int Table::read_snapshot(const string &filename) {
 
-    vector<double>::iterator cr;
-    double sum = 0;
+    reset();
 
-    cout.precision(numeric_limits<double>::digits10);
-    
-    cout << "(" << pr.size() << ") " << "[ ";
-    for (cr = pr.begin(); cr != pr.end(); cr++) {
-        cout << *cr << " ";
-        sum += *cr;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open file", filename.c_str());
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        error("Cannot map file", filename.c_str());
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    /*
+     * The rows are read into the table, as updates and reordering
+     * rewrite them in place; only the header and the names are parsed
+     * from the mapping.
+     */
+    const char *start = (const char *) addr;
+    const char *p = start;
+    const char *end = p + st.st_size;
+    SnapshotHeader header;
+    bool ok = read_header(p, end, header);
+    if (ok) {
+        wide_indices = (header.flags & SNAPSHOT_WIDE_INDICES) != 0;
+        numeric = (header.flags & SNAPSHOT_NUMERIC) != 0;
+        ok = load_section(fd, start, p, end, row_offsets,
+                          header.num_rows + 1)
+            && ((wide_indices)
+                ? load_section(fd, start, p, end, wide_col_indices,
+                               header.num_arcs)
+                : load_section(fd, start, p, end, col_indices,
+                               header.num_arcs))
+            && load_section(fd, start, p, end, num_outgoing,
+                            header.num_rows)
+            && (numeric || names.read(p, end))
+            && row_offsets.back() == header.num_arcs;
+    }
+
+    munmap(addr, st.st_size);
+    close(fd);
+
+    if (!ok) {
+        reset();
+        error("Invalid snapshot file", filename.c_str());
+    }
+
+    inv_outgoing.resize(num_outgoing.size());
+    for (size_t k = 0; k < num_outgoing.size(); k++) {
+        inv_outgoing[k] = (num_outgoing[k]) ? 1.0 / num_outgoing[k] : 0.0;
+    }
+    finalized = true;
+
+    cerr << "read snapshot of " << num_outgoing.size() << " vertices, "
+         << row_offsets.back() << " arcs" << endl;
+
+    return 0;
+}
+
+int Table::build_snapshot(const string &graph_filename,
+                          const string &filename) {
+
+    reset();
+
+    ifstream in(graph_filename.c_str());
+    if (!in) {
+        error("Cannot open file", graph_filename.c_str());
+    }
+
+    /* Read the arcs, writing them out in sorted runs */
+    vector<string> runs;
+    string line;
+    size_t linenum = 0;
+    while (getline(in, line)) {
+        read_line(line);
+        if (arcs.size() >= run_arcs) {
+            runs.push_back(filename + ".run" + to_string(runs.size()));
+            if (!write_run(arcs, runs.back())) {
+                error("Cannot write file", runs.back().c_str());
+            }
+        }
+
+        linenum++;
+        if ((linenum % 100000) == 0) {
+            cerr << "read " << linenum << " lines, "
+                 << num_outgoing.size() << " vertices" << endl;
+        }
+    }
+    if (!arcs.empty() || runs.empty()) {
+        runs.push_back(filename + ".run" + to_string(runs.size()));
+        if (!write_run(arcs, runs.back())) {
+            error("Cannot write file", runs.back().c_str());
+        }
+    }
+    cerr << "read " << linenum << " lines, "
+         << num_outgoing.size() << " vertices, sorted in " << runs.size()
+         << " runs" << endl;
+
+    ofstream out(filename.c_str(), ios::binary);
+    if (!out) {
+        error("Cannot open file", filename.c_str());
+    }
+
+    /*
+     * The header and the row offsets are written again once the runs
+     * have been merged and they are known.
+     */
+    size_t num_rows = num_outgoing.size();
+    wide_indices = force_wide_indices
+        || num_rows > numeric_limits<uint32_t>::max();
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    out.write((const char *) &header, sizeof(header));
+    row_offsets.assign(num_rows + 1, 0);
+    write_section(out, row_offsets);
+
+    size_t num_arcs;
+    bool merged = (wide_indices)
+        ? merge_runs<uint64_t>(runs, out, row_offsets, num_outgoing, num_arcs)
+        : merge_runs<uint32_t>(runs, out, row_offsets, num_outgoing, num_arcs);
+    if (!merged) {
+        error("Cannot read file", filename.c_str());
+    }
+    for (size_t k = 0; k < runs.size(); k++) {
+        remove(runs[k].c_str());
+    }
+    for (size_t i = 0; i < num_rows; i++) {
+        row_offsets[i + 1] += row_offsets[i];
+    }
+    write_section(out, num_outgoing);
+    if (!numeric) {
+        names.write(out);
+    }
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.flags = ((numeric) ? SNAPSHOT_NUMERIC : 0)
+        | ((wide_indices) ? SNAPSHOT_WIDE_INDICES : 0);
+    header.index_bytes = (wide_indices) ? sizeof(uint64_t) : sizeof(uint32_t);
+    header.num_rows = num_rows;
+    header.num_arcs = num_arcs;
+    out.seekp(0);
+    out.write((const char *) &header, sizeof(header));
+    write_section(out, row_offsets);
+
+    out.close();
+    if (!out) {
+        error("Cannot write file", filename.c_str());
+    }
+
+    cerr << "wrote snapshot of " << num_rows << " vertices, " << num_arcs
+         << " arcs" << endl;
+
+    reset();
+
+    return 0;
+}
+
+int Table::open_snapshot(const string &filename) {
+
+    reset();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open file", filename.c_str());
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        error("Cannot map file", filename.c_str());
+    }
+
+    /* Only the pages of the sections that are read are touched */
+    const char *start = (const char *) addr;
+    const char *p = start;
+    const char *end = p + st.st_size;
+    SnapshotHeader header;
+    bool ok = read_header(p, end, header);
+    if (ok) {
+        wide_indices = (header.flags & SNAPSHOT_WIDE_INDICES) != 0;
+        numeric = (header.flags & SNAPSHOT_NUMERIC) != 0;
+        stream_offsets_pos = p - start;
+        ok = skip_section<size_t>(p, end, header.num_rows + 1);
+        stream_cols_pos = p - start;
+        ok = ok
+            && ((wide_indices)
+                ? skip_section<uint64_t>(p, end, header.num_arcs)
+                : skip_section<uint32_t>(p, end, header.num_arcs));
+        stream_outgoing_pos = p - start;
+        ok = ok && read_section(p, end, num_outgoing, header.num_rows)
+            && (numeric || names.read(p, end));
+    }
+
+    munmap(addr, st.st_size);
+    close(fd);
+
+    if (!ok) {
+        reset();
+        error("Invalid snapshot file", filename.c_str());
+    }
+
+    inv_outgoing.resize(num_outgoing.size());
+    for (size_t k = 0; k < num_outgoing.size(); k++) {
+        inv_outgoing[k] = (num_outgoing[k]) ? 1.0 / num_outgoing[k] : 0.0;
+    }
+    finalized = true;
+    stream_filename = filename;
+
+    cerr << "opened snapshot of " << num_outgoing.size() << " vertices, "
+         << header.num_arcs << " arcs" << endl;
+
+    return 0;
+}
+
+int Table::worker_pagerank(const string &filename) {
+
+    reset();
+
+    string conflict = check_settings();
+    if (!conflict.empty()) {
+        error(conflict.c_str());
+    }
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open file", filename.c_str());
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        error("Cannot map file", filename.c_str());
+    }
+
+    /* Only the header, and the names for the first worker, are read */
+    const char *start = (const char *) addr;
+    const char *p = start;
+    const char *end = p + st.st_size;
+    SnapshotHeader header;
+    StreamedRows rows;
+    bool ok = read_header(p, end, header);
+    if (ok) {
+        wide_indices = (header.flags & SNAPSHOT_WIDE_INDICES) != 0;
+        numeric = (header.flags & SNAPSHOT_NUMERIC) != 0;
+        rows.filename = filename;
+        rows.num_rows = header.num_rows;
+        rows.offsets_pos = p - start;
+        ok = skip_section<size_t>(p, end, header.num_rows + 1);
+        rows.cols_pos = p - start;
+        ok = ok
+            && ((wide_indices)
+                ? skip_section<uint64_t>(p, end, header.num_arcs)
+                : skip_section<uint32_t>(p, end, header.num_arcs));
+        rows.outgoing_pos = p - start;
+        ok = ok && skip_section<size_t>(p, end, header.num_rows)
+            && (numeric || worker > 0 || names.read(p, end));
+    }
+
+    munmap(addr, st.st_size);
+    close(fd);
+
+    if (!ok) {
+        reset();
+        error("Invalid snapshot file", filename.c_str());
+    }
+
+    /* The workers check that they calculate the same on the same graph */
+    ostringstream agreed;
+    agreed.precision(numeric_limits<double>::max_digits10);
+    agreed << num_processes << " " << alpha << " " << convergence << " "
+           << max_iterations << " " << single_precision << " "
+           << header.num_rows << " " << header.num_arcs;
+    vector<int> fds;
+    if (!connect_workers(rendezvous, worker, num_processes, agreed.str(),
+                         fds)) {
+        error("Cannot join the other workers at", rendezvous.c_str());
+    }
+
+    if (wide_indices) {
+        ok = (single_precision)
+            ? snapshot_worker_iterate<uint64_t, float>(
+                rows, iteration_settings(), worker, fds, pr, num_iterations)
+            : snapshot_worker_iterate<uint64_t, double>(
+                rows, iteration_settings(), worker, fds, pr, num_iterations);
+    } else {
+        ok = (single_precision)
+            ? snapshot_worker_iterate<uint32_t, float>(
+                rows, iteration_settings(), worker, fds, pr, num_iterations)
+            : snapshot_worker_iterate<uint32_t, double>(
+                rows, iteration_settings(), worker, fds, pr, num_iterations);
+    }
+    for (size_t k = 0; k < fds.size(); k++) {
+        if (fds[k] >= 0) {
+            close(fds[k]);
+        }
+    }
+    if (!ok) {
+        error("A worker process failed");
+    }
+    finalized = true;
+
+    return 0;
+}
+
+size_t Table::read_pagerank(const string &filename) {
+
+    finalize();
+
+    size_t num_rows = num_outgoing.size();
+    size_t num_found = 0;
+    const double NOT_FOUND = -1;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open file", filename.c_str());
+    }
+    struct stat st;
+    void *addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        error("Cannot map file", filename.c_str());
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+    start_pr.assign(num_rows, NOT_FOUND);
+    auto found = [&](size_t index, double value) {
+        if (index < num_rows && value > 0 && isfinite(value)) {
+            if (start_pr[index] == NOT_FOUND) {
+                num_found++;
+            }
+            start_pr[index] = value;
+        }
+    };
+
+    const char *p = (const char *) addr;
+    const char *end = p + st.st_size;
+    /*
+     * A binary vector starts with the record of vertex 0, so with eight
+     * zero bytes, which no text output does.
+     */
+    const char zeros[sizeof(uint64_t)] = { 0 };
+    if (st.st_size % sizeof(PagerankRecord) == 0
+        && memcmp(p, zeros, sizeof(zeros)) == 0) {
+        PagerankRecord record;
+        for (; p < end; p += sizeof(record)) {
+            memcpy(&record, p, sizeof(record));
+            found(record.index, record.pagerank);
+        }
+    } else {
+        while (p < end) {
+            const char *eol = (const char *) memchr(p, '\n', end - p);
+            if (eol == NULL) {
+                eol = end;
+            }
+            string_view line(p, eol - p);
+            p = eol + 1;
+            size_t sep = line.rfind(" = ");
+            if (sep == string_view::npos) {
+                continue;
+            }
+            string_view name = line.substr(0, sep);
+            string_view value_str = trim(line.substr(sep + 3));
+            double value;
+            if (from_chars(value_str.data(),
+                           value_str.data() + value_str.size(),
+                           value).ec != errc()) {
+                continue;
+            }
+            size_t index;
+            if (numeric) {
+                from_chars_result r = from_chars(name.data(),
+                                                 name.data() + name.size(),
+                                                 index);
+                if (r.ec != errc() || r.ptr != name.data() + name.size()) {
+                    continue;
+                }
+            } else {
+                index = names.find(name);
+            }
+            found(index, value);
+        }
+    }
+
+    munmap(addr, st.st_size);
+    close(fd);
+
+    for (size_t k = 0; k < num_rows; k++) {
+        if (start_pr[k] == NOT_FOUND) {
+            start_pr[k] = 1.0 / num_rows;
+        }
+    }
+
+    cerr << "read pagerank of " << num_found << " of " << num_rows
+         << " vertices" << endl;
+
+    return num_found;
+}
+
+void Table::add_arc(size_t from, size_t to) {
+
+    size_t max_dim = max(from, to);
+    if (trace) {
+        cout << "checking to add " << from << " => " << to << endl;
+    }
+    if (num_outgoing.size() <= max_dim) {
+        max_dim = max_dim + 1;
+        if (trace) {
+            cout << "resizing rows from " << num_outgoing.size() << " to "
+                 << max_dim << endl;
+        }
+        num_outgoing.resize(max_dim);
+    }
+
+    arcs.push_back(pair<size_t, size_t>(from, to));
+}
+
+void Table::finalize() {
+
+    if (finalized) {
+        return;
+    }
+
+    size_t num_rows = num_outgoing.size();
+
+    wide_indices = force_wide_indices
+        || num_rows > numeric_limits<uint32_t>::max();
+    if (wide_indices) {
+        build_rows(wide_col_indices);
+    } else {
+        build_rows(col_indices);
+    }
+
+    inv_outgoing.resize(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        inv_outgoing[k] = (num_outgoing[k]) ? 1.0 / num_outgoing[k] : 0.0;
+    }
+
+    finalized = true;
+}
+
+template <class Index>
+void Table::build_rows(vector<Index> &cols) {
+
+    size_t num_rows = num_outgoing.size();
+    size_t num_arcs = arcs.size();
+    vector< pair<size_t, size_t> >::const_iterator ca; // current arc
+
+    /* Count the incoming arcs of each row, shifted by one ... */
+    row_offsets.assign(num_rows + 1, 0);
+    for (ca = arcs.begin(); ca != arcs.end(); ca++) {
+        row_offsets[ca->second + 1]++;
+    }
+    /* ... so that their prefix sums give the start of each row */
+    for (size_t i = 0; i < num_rows; i++) {
+        row_offsets[i + 1] += row_offsets[i];
+    }
+
+    /* Scatter the arcs into their rows; the counting sort is stable */
+    cols.resize(num_arcs);
+    vector<size_t> next(row_offsets.begin(), row_offsets.end() - 1);
+    for (ca = arcs.begin(); ca != arcs.end(); ca++) {
+        cols[next[ca->second]++] = ca->first;
+    }
+    vector<size_t>().swap(next);
+    vector< pair<size_t, size_t> >().swap(arcs);
+
+    /* Sort each row and drop its duplicate arcs, in parallel ... */
+    vector<size_t> row_length(num_rows);
+    vector<size_t> bounds;
+    partition_blocks(bounds);
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+        size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+        for (size_t i = first; i < last; i++) {
+            Index *row_begin = cols.data() + row_offsets[i];
+            Index *row_end = cols.data() + row_offsets[i + 1];
+            sort(row_begin, row_end);
+            row_length[i] = unique(row_begin, row_end) - row_begin;
+        }
+    });
+
+    /*
+     * ... and then compact the rows; only the unique arcs count as
+     * outgoing links.
+     */
+    num_outgoing.assign(num_rows, 0);
+    size_t num_unique = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        const Index *row_begin = cols.data() + row_offsets[i];
+        row_offsets[i] = num_unique;
+        for (size_t k = 0; k < row_length[i]; k++) {
+            Index cc = row_begin[k]; // current column
+            cols[num_unique++] = cc;
+            num_outgoing[cc]++;
+            if (trace) {
+                cout << "added " << cc << " => " << i << endl;
+            }
+        }
+    }
+    row_offsets[num_rows] = num_unique;
+    cols.resize(num_unique);
+    cols.shrink_to_fit();
+}
+
+size_t Table::get_col_index(size_t k) {
+    return (wide_indices) ? wide_col_indices[k] : col_indices[k];
+}
+
+void Table::partition_blocks(vector<size_t> &bounds) {
+    partition_blocks(row_offsets, bounds);
+}
+
+void Table::partition_blocks(const vector<size_t> &offsets,
+                             vector<size_t> &bounds) {
+    partition_rows(offsets, bounds, num_threads);
+}
+
+void Table::pagerank() {
+
+    string failure = try_pagerank();
+    if (!failure.empty()) {
+        error(failure.c_str());
+    }
+}
+
+const string Table::try_pagerank() {
+
+    string conflict = check_settings();
+    if (!conflict.empty()) {
+        return conflict;
+    }
+
+    finalize();
+
+    size_t num_rows = num_outgoing.size();
+    
+    if (num_rows == 0) {
+        return "";
+    }
+    
+    /* Any later update_pagerank() starts over from the new results */
+    incremental.clear();
+
+    if (start_pr.size() == num_rows) {
+        double sum = 0;
+        for (size_t k = 0; k < num_rows; k++) {
+            sum += start_pr[k];
+        }
+        pr.resize(num_rows);
+        for (size_t k = 0; k < num_rows; k++) {
+            pr[k] = start_pr[original_index(k)] / sum;
+        }
+    } else {
+        /* All on the first vertex, wherever reordering has put it */
+        size_t first = 0;
+        while (original_index(first) != 0) {
+            first++;
+        }
+        pr.assign(num_rows, 0);
+        pr[first] = 1;
+    }
+
+    if (trace) {
+        print_pagerank();
+    }
+
+    if (!stream_filename.empty()) {
+        extrapolation_savings.clear();
+        StreamedRows rows = { stream_filename, num_outgoing.size(),
+                              stream_offsets_pos, stream_cols_pos,
+                              stream_outgoing_pos };
+        function<void(unsigned long, const vector<double> &)> traced;
+        if (trace) {
+            traced = [&](unsigned long iteration, const vector<double> &) {
+                cout << iteration << ": ";
+                print_pagerank();
+            };
+        }
+        bool streamed;
+        if (wide_indices) {
+            streamed = (single_precision)
+                ? stream_iterate<uint64_t, float>(rows, inv_outgoing,
+                                                  iteration_settings(), pr,
+                                                  traced, num_iterations)
+                : stream_iterate<uint64_t, double>(rows, inv_outgoing,
+                                                   iteration_settings(), pr,
+                                                   traced, num_iterations);
+        } else {
+            streamed = (single_precision)
+                ? stream_iterate<uint32_t, float>(rows, inv_outgoing,
+                                                  iteration_settings(), pr,
+                                                  traced, num_iterations)
+                : stream_iterate<uint32_t, double>(rows, inv_outgoing,
+                                                   iteration_settings(), pr,
+                                                   traced, num_iterations);
+        }
+        if (!streamed) {
+            return "Cannot read file " + stream_filename;
+        }
+    } else {
+        bool iterated;
+        if (wide_indices) {
+            iterated = (single_precision)
+                ? iterate<uint64_t, float>(wide_col_indices,
+                                           wide_out_col_indices)
+                : iterate<uint64_t, double>(wide_col_indices,
+                                            wide_out_col_indices);
+        } else {
+            iterated = (single_precision)
+                ? iterate<uint32_t, float>(col_indices, out_col_indices)
+                : iterate<uint32_t, double>(col_indices, out_col_indices);
+        }
+        if (!iterated) {
+            return "A worker process failed";
+        }
+    }
+    restore_order(pr);
+    return "";
+}
+
+void Table::reorder(Ordering o) {
+
+    finalize();
+
+    if (!stream_filename.empty()) {
+        error("Cannot reorder a streamed graph");
+    }
+    if (num_outgoing.size() == 0) {
+        return;
+    }
+
+    /* Any later update_pagerank() would start from the old indices */
+    incremental.clear();
+
+    if (wide_indices) {
+        reorder_rows(wide_col_indices, wide_out_col_indices, o);
+    } else {
+        reorder_rows(col_indices, out_col_indices, o);
+    }
+}
+
+bool Table::reorder(const string &name) {
+    for (int o = 0; o < NUM_ORDERINGS; o++) {
+        if (name == ORDERING_NAMES[o]) {
+            reorder((Ordering) o);
+            return true;
+        }
+    }
+    return false;
+}
+
+const bool Table::get_reordered() {
+    return !order.empty();
+}
+
+size_t Table::original_index(size_t k) {
+    return (order.empty()) ? k : order[k];
+}
+
+void Table::restore_order(vector<double> &v) {
+
+    if (order.empty()) {
+        return;
+    }
+
+    vector<double> restored(v.size());
+    for (size_t k = 0; k < v.size(); k++) {
+        restored[order[k]] = v[k];
+    }
+    v.swap(restored);
+}
+
+template <class Index>
+void Table::reorder_rows(vector<Index> &cols, vector<Index> &out_cols,
+                         Ordering o) {
+
+    size_t num_rows = num_outgoing.size();
+    vector<size_t> new_order;
+
+    if (o == ORDERING_DEGREE) {
+        degree_order(new_order);
+    } else {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(cols, out_cols);
+        }
+        if (o == ORDERING_RCM) {
+            rcm_order(cols, out_cols, new_order);
+        } else {
+            gorder_order(cols, out_cols, new_order);
+        }
+    }
+
+    /* The outgoing arcs are rebuilt for the new indices when needed */
+    vector<size_t>().swap(out_row_offsets);
+    vector<Index>().swap(out_cols);
+
+    permute_rows(cols, new_order);
+}
+
+void Table::degree_order(vector<size_t> &new_order) {
+
+    size_t num_rows = num_outgoing.size();
+
+    new_order.resize(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        new_order[k] = k;
+    }
+    stable_sort(new_order.begin(), new_order.end(),
+                [&](size_t a, size_t b) {
+                    return num_outgoing[a] > num_outgoing[b];
+                });
+}
+
+template <class Index>
+void Table::rcm_order(const vector<Index> &cols, const vector<Index> &out_cols,
+                      vector<size_t> &new_order) {
+
+    size_t num_rows = num_outgoing.size();
+
+    vector<size_t> degree(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        degree[k] = row_offsets[k + 1] - row_offsets[k] + num_outgoing[k];
+    }
+    auto by_degree = [&](size_t a, size_t b) {
+        return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+    };
+
+    /* Each component starts from its vertex with the fewest arcs */
+    vector<size_t> starts(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        starts[k] = k;
+    }
+    sort(starts.begin(), starts.end(), by_degree);
+
+    vector<bool> visited(num_rows, false);
+    new_order.clear();
+    new_order.reserve(num_rows);
+    for (size_t s = 0; s < num_rows; s++) {
+        if (visited[starts[s]]) {
+            continue;
+        }
+        visited[starts[s]] = true;
+        new_order.push_back(starts[s]);
+        /* Breadth first, the neighbours of each vertex by degree */
+        for (size_t head = new_order.size() - 1; head < new_order.size();
+             head++) {
+            size_t v = new_order[head];
+            size_t first = new_order.size();
+            for (size_t k = row_offsets[v]; k < row_offsets[v + 1]; k++) {
+                if (!visited[cols[k]]) {
+                    visited[cols[k]] = true;
+                    new_order.push_back(cols[k]);
+                }
+            }
+            for (size_t k = out_row_offsets[v]; k < out_row_offsets[v + 1];
+                 k++) {
+                if (!visited[out_cols[k]]) {
+                    visited[out_cols[k]] = true;
+                    new_order.push_back(out_cols[k]);
+                }
+            }
+            sort(new_order.begin() + first, new_order.end(), by_degree);
+        }
+    }
+    reverse(new_order.begin(), new_order.end());
+}
+
+template <class Index>
+void Table::gorder_order(const vector<Index> &cols,
+                         const vector<Index> &out_cols,
+                         vector<size_t> &new_order) {
+
+    size_t num_rows = num_outgoing.size();
+    const size_t NONE = numeric_limits<size_t>::max();
+
+    /*
+     * The score of each unplaced vertex, its arcs to and from the
+     * vertices in the window plus the incoming neighbours it shares with
+     * them, is kept in a bucket list per score (a unit heap), so that
+     * scores change by one in constant time and the highest is found by
+     * moving down from the last one.
+     */
+    vector<size_t> score(num_rows, 0);
+    vector<size_t> next(num_rows), prev(num_rows);
+    vector<size_t> bucket(1, NONE);
+    vector<bool> placed(num_rows, false);
+    size_t top = 0;
+    auto unlink = [&](size_t v) {
+        if (prev[v] != NONE) {
+            next[prev[v]] = next[v];
+        } else {
+            bucket[score[v]] = next[v];
+        }
+        if (next[v] != NONE) {
+            prev[next[v]] = prev[v];
+        }
+    };
+    auto link = [&](size_t v) {
+        if (score[v] >= bucket.size()) {
+            bucket.resize(score[v] + 1, NONE);
+        }
+        prev[v] = NONE;
+        next[v] = bucket[score[v]];
+        if (next[v] != NONE) {
+            prev[next[v]] = v;
+        }
+        bucket[score[v]] = v;
+        top = max(top, score[v]);
+    };
+    auto change = [&](size_t v, bool up) {
+        if (!placed[v]) {
+            unlink(v);
+            if (up) {
+                score[v]++;
+            } else {
+                score[v]--;
+            }
+            link(v);
+        }
+    };
+
+    /*
+     * With no score to go by, the vertex with the most incoming arcs
+     * comes first, so they go last into the bucket.
+     */
+    vector<size_t> by_indegree(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        by_indegree[k] = k;
+    }
+    stable_sort(by_indegree.begin(), by_indegree.end(),
+                [&](size_t a, size_t b) {
+                    return row_offsets[a + 1] - row_offsets[a]
+                        < row_offsets[b + 1] - row_offsets[b];
+                });
+    for (size_t k = 0; k < num_rows; k++) {
+        link(by_indegree[k]);
+    }
+    vector<size_t>().swap(by_indegree);
+
+    /* Changes the scores of the vertices related to v by one */
+    auto update = [&](size_t v, bool up) {
+        for (size_t k = out_row_offsets[v]; k < out_row_offsets[v + 1];
+             k++) {
+            change(out_cols[k], up);
+        }
+        for (size_t k = row_offsets[v]; k < row_offsets[v + 1]; k++) {
+            size_t u = cols[k];
+            change(u, up);
+            if (num_outgoing[u] <= GORDER_MAX_SIBLINGS) {
+                for (size_t j = out_row_offsets[u];
+                     j < out_row_offsets[u + 1]; j++) {
+                    change(out_cols[j], up);
+                }
+            }
+        }
+    };
+
+    new_order.clear();
+    new_order.reserve(num_rows);
+    while (new_order.size() < num_rows) {
+        while (bucket[top] == NONE) {
+            top--;
+        }
+        size_t v = bucket[top];
+        unlink(v);
+        placed[v] = true;
+        new_order.push_back(v);
+        update(v, true);
+        if (new_order.size() > GORDER_WINDOW) {
+            update(new_order[new_order.size() - 1 - GORDER_WINDOW], false);
+        }
+    }
+}
+
+template <class Index>
+void Table::permute_rows(vector<Index> &cols, const vector<size_t> &new_order) {
+
+    size_t num_rows = num_outgoing.size();
+
+    vector<size_t> rank(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        rank[new_order[k]] = k;
+    }
+
+    vector<size_t> old_offsets(num_rows + 1);
+    old_offsets.swap(row_offsets);
+    row_offsets[0] = 0;
+    for (size_t k = 0; k < num_rows; k++) {
+        size_t v = new_order[k];
+        row_offsets[k + 1] = row_offsets[k]
+            + old_offsets[v + 1] - old_offsets[v];
+    }
+
+    /* Each new row is the old one, renumbered and sorted again */
+    vector<Index> new_cols(cols.size());
+    vector<size_t> bounds;
+    partition_blocks(bounds);
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+        size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+        for (size_t i = first; i < last; i++) {
+            size_t v = new_order[i];
+            Index *row = new_cols.data() + row_offsets[i];
+            for (size_t k = old_offsets[v]; k < old_offsets[v + 1]; k++) {
+                *row++ = rank[cols[k]];
+            }
+            sort(new_cols.data() + row_offsets[i], row);
+        }
+    });
+    cols.swap(new_cols);
+
+    vector<size_t> new_outgoing(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        new_outgoing[k] = num_outgoing[new_order[k]];
+        inv_outgoing[k] = (new_outgoing[k]) ? 1.0 / new_outgoing[k] : 0.0;
+    }
+    num_outgoing.swap(new_outgoing);
+
+    if (order.empty()) {
+        order = new_order;
+    } else {
+        vector<size_t> composed(num_rows);
+        for (size_t k = 0; k < num_rows; k++) {
+            composed[k] = order[new_order[k]];
+        }
+        order.swap(composed);
+    }
+}
+
+void Table::insert_arc(string_view from, string_view to) {
+
+    DeltaArc arc;
+    if (!numeric) {
+        arc.from = insert_mapping(from);
+        arc.to = insert_mapping(to);
+    } else {
+        arc.from = parse_index(from);
+        arc.to = parse_index(to);
+    }
+    arc.insert = true;
+    delta_arcs.push_back(arc);
+}
+
+void Table::delete_arc(string_view from, string_view to) {
+
+    DeltaArc arc;
+    if (!numeric) {
+        arc.from = names.find(from);
+        arc.to = names.find(to);
+        if (arc.from == Dictionary::npos || arc.to == Dictionary::npos) {
+            return;
+        }
+    } else {
+        arc.from = parse_index(from);
+        arc.to = parse_index(to);
+    }
+    arc.insert = false;
+    delta_arcs.push_back(arc);
+}
+
+bool Table::read_delta(istream &in) {
+
+    string line; // current line
+    bool read = false;
+    while (getline(in, line)) {
+        string_view change = trim(line);
+        if (change.empty()) {
+            if (read) {
+                break;
+            }
+            continue;
+        }
+        read = true;
+        string_view from, to;
+        if ((change[0] == '+' || change[0] == '-')
+            && split_line(trim(change.substr(1)), from, to)) {
+            if (change[0] == '+') {
+                insert_arc(from, to);
+            } else {
+                delete_arc(from, to);
+            }
+        }
+    }
+    return read;
+}
+
+void Table::update_pagerank() {
+
+    finalize();
+
+    if (!stream_filename.empty()) {
+        error("Cannot update the pagerank of a streamed graph");
+    }
+    if (!order.empty()) {
+        error("Cannot update the pagerank of a reordered graph");
+    }
+
+    size_t num_rows = num_outgoing.size();
+    if (pr.size() != num_rows) {
+        pagerank();
+    }
+
+    /* Switch to 64 bit indices if the new vertices need them */
+    size_t max_index = 0;
+    for (size_t k = 0; k < delta_arcs.size(); k++) {
+        if (delta_arcs[k].insert) {
+            max_index = max(max_index,
+                            max(delta_arcs[k].from, delta_arcs[k].to));
+        }
+    }
+    if (!wide_indices && max_index >= numeric_limits<uint32_t>::max()) {
+        wide_col_indices.assign(col_indices.begin(), col_indices.end());
+        vector<uint32_t>().swap(col_indices);
+        wide_out_col_indices.assign(out_col_indices.begin(),
+                                    out_col_indices.end());
+        vector<uint32_t>().swap(out_col_indices);
+        wide_indices = true;
+    }
+
+    if (wide_indices) {
+        apply_delta(wide_col_indices, wide_out_col_indices);
+    } else {
+        apply_delta(col_indices, out_col_indices);
+    }
+    delta_arcs.clear();
+}
+
+const unsigned long Table::get_num_pushes() {
+    return num_pushes;
+}
+
+const double Table::get_error_bound() {
+    return incremental.get_error_bound();
+}
+
+template <class Index>
+void Table::merge_rows(vector<size_t> &offsets, vector<Index> &cols,
+                       const vector<DeltaArc> &delta, bool by_source) {
+
+    size_t num_rows = offsets.size() - 1;
+    vector<size_t> new_offsets(num_rows + 1);
+    vector<Index> new_cols;
+    new_cols.reserve(cols.size() + delta.size());
+
+    auto row = [&](const DeltaArc &a) { return (by_source) ? a.from : a.to; };
+    auto col = [&](const DeltaArc &a) { return (by_source) ? a.to : a.from; };
+
+    vector<DeltaArc>::const_iterator d = delta.begin(); // current change
+    for (size_t i = 0; i < num_rows; i++) {
+        new_offsets[i] = new_cols.size();
+        const Index *c = cols.data() + offsets[i];
+        const Index *row_end = cols.data() + offsets[i + 1];
+        /* Rows without changes are copied as they are ... */
+        if (d == delta.end() || row(*d) != i) {
+            new_cols.insert(new_cols.end(), c, row_end);
+            continue;
+        }
+        /* ... and the rest are merged with their changes */
+        while (c != row_end || (d != delta.end() && row(*d) == i)) {
+            if (d == delta.end() || row(*d) != i
+                || (c != row_end && *c < col(*d))) {
+                new_cols.push_back(*c++);
+            } else {
+                if (c != row_end && *c == col(*d)) {
+                    c++;
+                }
+                if (d->insert) {
+                    new_cols.push_back(col(*d));
+                }
+                d++;
+            }
+        }
+    }
+    new_offsets[num_rows] = new_cols.size();
+
+    offsets.swap(new_offsets);
+    cols.swap(new_cols);
+}
+
+template <class Index>
+void Table::build_out_rows(const vector<Index> &cols, vector<Index> &out_cols) {
+
+    size_t num_rows = num_outgoing.size();
+
+    /* The outgoing arcs, sorted, as the rows are scanned in order */
+    out_row_offsets.assign(num_rows + 1, 0);
+    for (size_t k = 0; k < num_rows; k++) {
+        out_row_offsets[k + 1] = out_row_offsets[k] + num_outgoing[k];
+    }
+    out_cols.resize(cols.size());
+    vector<size_t> next(out_row_offsets.begin(), out_row_offsets.end() - 1);
+    for (size_t i = 0; i < num_rows; i++) {
+        for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+            out_cols[next[cols[k]]++] = i;
+        }
+    }
+}
+
+template <class Index>
+Csr<Index> Table::in_rows(const vector<Index> &cols) {
+    return Csr<Index>{ row_offsets, cols, inv_outgoing };
+}
+
+template <class Index>
+Csr<Index> Table::out_rows(const vector<Index> &out_cols) {
+    return Csr<Index>{ out_row_offsets, out_cols, inv_outgoing };
+}
+
+const string Table::check_settings() {
+
+    if (extrapolation != EXTRAPOLATION_NONE
+        && solver == SOLVER_GAUSS_SEIDEL) {
+        return "Cannot extrapolate the Gauss-Seidel solver";
+    }
+    if (extrapolation_period < MIN_EXTRAPOLATION_PERIODS[extrapolation]) {
+        return string("Extrapolation period too short for ")
+            + get_extrapolation_name();
+    }
+    if (skip_trivial && (solver == SOLVER_GAUSS_SEIDEL || bin_width > 0
+                         || extrapolation != EXTRAPOLATION_NONE)) {
+        return "Cannot skip trivial vertices with the Gauss-Seidel solver, "
+            "a bin width or extrapolation";
+    }
+    if (adaptive_tolerance > 0
+        && (solver == SOLVER_GAUSS_SEIDEL || bin_width > 0
+            || extrapolation != EXTRAPOLATION_NONE || skip_trivial)) {
+        return "Cannot iterate adaptively with the Gauss-Seidel solver, "
+            "a bin width, extrapolation or skipping trivial vertices";
+    }
+    if ((num_processes > 1 || !rendezvous.empty())
+        && (solver == SOLVER_GAUSS_SEIDEL || bin_width > 0
+            || extrapolation != EXTRAPOLATION_NONE || skip_trivial
+            || adaptive_tolerance > 0)) {
+        return "Cannot split among processes the Gauss-Seidel solver, "
+            "a bin width, extrapolation, skipping trivial vertices or "
+            "the adaptive power method";
+    }
+    if (!stream_filename.empty()
+        && (solver == SOLVER_GAUSS_SEIDEL || bin_width > 0
+            || extrapolation != EXTRAPOLATION_NONE || skip_trivial
+            || adaptive_tolerance > 0 || num_processes > 1)) {
+        return "Cannot stream the Gauss-Seidel solver, a bin width, "
+            "extrapolation, skipping trivial vertices, the adaptive power "
+            "method or more than one process";
+    }
+    return "";
+}
+
+IterationSettings Table::iteration_settings() {
+    IterationSettings settings = { alpha, convergence, max_iterations,
+                                   num_threads };
+    return settings;
+}
+
+template <class Index>
+void Table::apply_delta(vector<Index> &cols, vector<Index> &out_cols) {
+
+    size_t old_rows = num_outgoing.size();
+    size_t num_rows = old_rows;
+
+    if (out_row_offsets.size() != num_rows + 1) {
+        build_out_rows(cols, out_cols);
+    }
+    if (!incremental.started(num_rows)) {
+        incremental.start(in_rows(cols), pr, alpha, num_threads);
+    }
+
+    /* Keep the last change of each arc, in the order of the sources */
+    stable_sort(delta_arcs.begin(), delta_arcs.end(),
+                [](const DeltaArc &a, const DeltaArc &b) {
+                    return a.from < b.from
+                        || (a.from == b.from && a.to < b.to);
+                });
+    vector<DeltaArc> delta;
+    for (size_t k = 0; k < delta_arcs.size(); k++) {
+        const DeltaArc &a = delta_arcs[k];
+        if (k + 1 < delta_arcs.size() && delta_arcs[k + 1].from == a.from
+            && delta_arcs[k + 1].to == a.to) {
+            continue;
+        }
+        if (a.insert) {
+            num_rows = max(num_rows, max(a.from, a.to) + 1);
+            delta.push_back(a);
+        } else if (a.from < old_rows && a.to < old_rows) {
+            delta.push_back(a);
+        }
+    }
+
+    /* New vertices start with no rank and the constant as residual */
+    num_outgoing.resize(num_rows);
+    inv_outgoing.resize(num_rows);
+    row_offsets.resize(num_rows + 1, row_offsets.back());
+    out_row_offsets.resize(num_rows + 1, out_row_offsets.back());
+    incremental.add_vertices(num_rows);
+
+    incremental.move_shares(out_rows(out_cols), delta, alpha, -1);
+    merge_rows(out_row_offsets, out_cols, delta, true);
+    for (size_t k = 0; k < delta.size(); k++) {
+        size_t u = delta[k].from;
+        num_outgoing[u] = out_row_offsets[u + 1] - out_row_offsets[u];
+        inv_outgoing[u] = (num_outgoing[u]) ? 1.0 / num_outgoing[u] : 0.0;
+    }
+    incremental.move_shares(out_rows(out_cols), delta, alpha, 1);
+
+    sort(delta.begin(), delta.end(),
+         [](const DeltaArc &a, const DeltaArc &b) {
+             return a.to < b.to || (a.to == b.to && a.from < b.from);
+         });
+    merge_rows(row_offsets, cols, delta, false);
+
+    incremental.push(out_rows(out_cols), alpha, convergence, pr);
+    num_pushes = incremental.get_num_pushes();
+}
+void Table::monte_carlo_pagerank(unsigned long walks) {
+
+    finalize();
+
+    if (!stream_filename.empty()) {
+        error("Cannot estimate the pagerank of a streamed graph");
+    }
+
+    size_t num_rows = num_outgoing.size();
+
+    if (num_rows == 0) {
+        return;
+    }
+
+    /* Any later update_pagerank() starts over from the new results */
+    incremental.clear();
+
+    if (wide_indices) {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(wide_col_indices, wide_out_col_indices);
+        }
+        num_steps = random_walks(out_rows(wide_out_col_indices), walks,
+                                 alpha, num_threads, pr);
+    } else {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(col_indices, out_col_indices);
+        }
+        num_steps = random_walks(out_rows(out_col_indices), walks, alpha,
+                                 num_threads, pr);
+    }
+    restore_order(pr);
+}
+
+const unsigned long Table::get_num_steps() {
+    return num_steps;
+}
+
+double Table::local_pagerank(const vector<size_t> &seeds, double epsilon,
+                             size_t k, vector< pair<size_t, double> > &top) {
+
+    finalize();
+
+    if (!stream_filename.empty()) {
+        error("Cannot push from seeds in a streamed graph");
+    }
+    if (!order.empty()) {
+        error("Cannot push from seeds in a reordered graph");
+    }
+
+    size_t num_rows = num_outgoing.size();
+    double unpushed;
+    if (wide_indices) {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(wide_col_indices, wide_out_col_indices);
+        }
+        unpushed = local_push.push(out_rows(wide_out_col_indices), alpha,
+                                   seeds, epsilon, k, top);
+    } else {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(col_indices, out_col_indices);
+        }
+        unpushed = local_push.push(out_rows(out_col_indices), alpha, seeds,
+                                   epsilon, k, top);
+    }
+    num_pushes = local_push.get_num_pushes();
+    return unpushed;
+}
+
+double Table::local_pagerank(string_view seed, double epsilon, size_t k,
+                             vector< pair<size_t, double> > &top) {
+
+    finalize();
+
+    vector<size_t> seeds;
+    size_t index = (numeric) ? parse_index(seed) : names.find(seed);
+    if (index < num_outgoing.size()) {
+        seeds.push_back(index);
+    }
+    return local_pagerank(seeds, epsilon, k, top);
+}
+
+void Table::add_seed(string_view set, string_view vertex) {
+
+    finalize();
+
+    size_t index;
+    if (!numeric) {
+        index = names.find(vertex);
+    } else {
+        index = parse_index(vertex);
+    }
+    if (index >= num_outgoing.size()) {
+        return;
+    }
+
+    string set_name(set);
+    unordered_map<string, size_t>::iterator s =
+        seed_set_index.find(set_name);
+    if (s == seed_set_index.end()) {
+        s = seed_set_index.insert(
+            make_pair(set_name, seed_set_names.size())).first;
+        seed_set_names.push_back(set_name);
+        seed_sets.push_back(vector<size_t>());
+    }
+    seed_sets[s->second].push_back(index);
+}
+
+size_t Table::read_seeds(const string &filename) {
+
+    ifstream in(filename.c_str());
+    if (!in) {
+        error("Cannot open file", filename.c_str());
+    }
+
+    string line; // current line
+    string_view set, vertex;
+    while (getline(in, line)) {
+        if (split_line(line, set, vertex)) {
+            add_seed(set, vertex);
+        }
+    }
+
+    cerr << "read " << seed_sets.size() << " seed sets" << endl;
+
+    return seed_sets.size();
+}
+
+const size_t Table::get_num_seed_sets() {
+    return seed_sets.size();
+}
+
+const string &Table::get_seed_set_name(size_t s) {
+    return seed_set_names[s];
+}
+
+void Table::personalized_pagerank(const function<void(size_t)> &done) {
+
+    finalize();
+
+    if (!stream_filename.empty()) {
+        error("Cannot personalize the pagerank of a streamed graph");
+    }
+    if (!order.empty()) {
+        error("Cannot personalize the pagerank of a reordered graph");
+    }
+
+    if (num_outgoing.size() == 0) {
+        return;
+    }
+
+    /* A vertex listed more than once in a set counts once */
+    for (size_t s = 0; s < seed_sets.size(); s++) {
+        sort(seed_sets[s].begin(), seed_sets[s].end());
+        seed_sets[s].erase(unique(seed_sets[s].begin(), seed_sets[s].end()),
+                           seed_sets[s].end());
+    }
+
+    /* Each set's results become those of the table as it is done */
+    auto finished = [&](size_t s, unsigned long iterations) {
+        num_iterations = iterations;
+        done(s);
+    };
+    IterationSettings settings = iteration_settings();
+    if (wide_indices) {
+        if (single_precision) {
+            personalized_iterate<uint64_t, float>(in_rows(wide_col_indices),
+                                                  seed_sets, settings, pr,
+                                                  finished);
+        } else {
+            personalized_iterate<uint64_t, double>(in_rows(wide_col_indices),
+                                                   seed_sets, settings, pr,
+                                                   finished);
+        }
+    } else {
+        if (single_precision) {
+            personalized_iterate<uint32_t, float>(in_rows(col_indices),
+                                                  seed_sets, settings, pr,
+                                                  finished);
+        } else {
+            personalized_iterate<uint32_t, double>(in_rows(col_indices),
+                                                   seed_sets, settings, pr,
+                                                   finished);
+        }
+    }
+}
+
+template <class Index, class Value>
+bool Table::iterate(const vector<Index> &cols, vector<Index> &out_cols) {
+
+    num_iterations = 0;
+    extrapolation_savings.clear();
+    switch (solver) {
+    case SOLVER_GAUSS_SEIDEL:
+        gauss_seidel<Index, Value>(cols);
+        break;
+    case SOLVER_POWER:
+    default:
+        if (num_processes > 1) {
+            if (!distributed_iterate<Index, Value>(in_rows(cols),
+                                                   iteration_settings(),
+                                                   num_processes, pr,
+                                                   num_iterations)) {
+                return false;
+            }
+        } else if (adaptive_tolerance > 0) {
+            adaptive_iterate<Index, Value>(cols);
+        } else if (skip_trivial) {
+            core_iterate<Index, Value>(cols);
+        } else {
+            power_iterate<Index, Value>(cols, out_cols);
+        }
+        break;
+    }
+    return true;
+}
+
+template <class Index, class Value>
+void Table::power_iterate(const vector<Index> &cols,
+                          vector<Index> &out_cols) {
+
+    double diff = 1;
+    double sum_pr; // sum of current pagerank vector elements
+    double dangling_pr; // sum of current pagerank vector elements for dangling
+    			// nodes
+    size_t num_rows = num_outgoing.size();
+
+    /*
+     * The pagerank vector and its previous, normalised, value; the
+     * results are copied back to pr at the end.
+     */
+    vector<Value> cur_pr(pr.begin(), pr.end());
+    vector<Value> old_pr(num_rows);
+    vector<double>().swap(pr);
+
+    /*
+     * The share of the previous pagerank of each vertex passed along
+     * each of its outgoing links, so that the H multiplication needs a
+     * single random access per link.
+     */
+    vector<Value> out_pr(num_rows);
+
+    /*
+     * The two iterates before old_pr, kept only for extrapolation; the
+     * iterations since the last extrapolation, and the iteration and
+     * diff when the last extrapolation was applied, for estimating its
+     * savings.
+     */
+    bool extrapolating = extrapolation != EXTRAPOLATION_NONE;
+    vector<Value> hist2(extrapolating ? num_rows : 0);
+    vector<Value> hist3(extrapolating ? num_rows : 0);
+    unsigned long since_extrapolation = 0;
+    unsigned long extrapolated_at = 0;
+    double extrapolated_diff = 0;
+
+    /*
+     * Compares the diff of the last iteration with what it would have
+     * been without the last extrapolation, had each power iteration
+     * reduced it by a factor of alpha, which bounds the asymptotic rate
+     * of the power method. The comparison is made just before the next
+     * extrapolation, or at the end, as the first iterations after an
+     * extrapolation may have larger diffs even when it helped.
+     */
+    auto record_savings = [&]() {
+        if (extrapolated_at > 0 && alpha < 1 && diff > 0) {
+            double saved = log(diff / extrapolated_diff) / log(alpha)
+                - (double) (num_iterations - extrapolated_at);
+            extrapolation_savings.push_back(
+                make_pair(extrapolated_at, saved));
+        }
+        extrapolated_at = 0;
+    };
+
+    /* Per block sums of the pagerank vector, its dangling part and diff */
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    vector<double> block_sum(num_blocks);
+    vector<double> block_dangling(num_blocks);
+    vector<double> block_diff(num_blocks);
+    vector<size_t> bounds;
+    partition_blocks(bounds);
+
+    for (size_t k = 0; k < num_rows; k++) {
+        block_sum[k / BLOCK_ROWS] += cur_pr[k];
+        if (num_outgoing[k] == 0) {
+            block_dangling[k / BLOCK_ROWS] += cur_pr[k];
+        }
+    }
+
+    /* The layout and the values of the propagation blocking kernel */
+    Bins<Index> bins;
+    vector<Value> values;
+    if (bin_width > 0) {
+        if (out_row_offsets.size() != num_rows + 1) {
+            build_out_rows(cols, out_cols);
+        }
+        build_bins(out_cols, bins);
+    }
+    
+    while (diff > convergence && num_iterations < max_iterations) {
+
+        sum_pr = 0;
+        dangling_pr = 0;
+        
+        for (size_t b = 0; b < num_blocks; b++) {
+            sum_pr += block_sum[b];
+            dangling_pr += block_dangling[b];
+        }
+
+        /*
+         * Normalize so that we start with sum equal to one; the initial
+         * vector is used as is.
+         */
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+            size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+            for (size_t i = first; i < last; i++) {
+                old_pr[i] = (num_iterations == 0)
+                    ? cur_pr[i]
+                    : cur_pr[i] / sum_pr;
+                out_pr[i] = inv_outgoing[i] * old_pr[i];
+            }
+        });
+
+        /*
+         * After normalisation the elements of the pagerank vector sum
+         * to one
+         */
+        sum_pr = 1;
+        
+        /* An element of the A x I vector; all elements are identical */
+        double one_Av = alpha * dangling_pr / num_rows;
+
+        /* An element of the 1 x I vector; all elements are identical */
+        double one_Iv = (1 - alpha) * sum_pr / num_rows;
+
+        if (bin_width > 0) {
+            bin_multiply(out_cols, bins, values, out_pr, old_pr, cur_pr,
+                         one_Av, one_Iv, block_diff, block_sum,
+                         block_dangling);
+        } else {
+            if (num_iterations == 0 && trace) {
+                /* The elements of the H matrix, before the threads start */
+                for (size_t i = 0; i < num_rows; i++) {
+                    for (size_t k = row_offsets[i]; k < row_offsets[i + 1];
+                         k++) {
+                        cout << "h[" << i << "," << cols[k] << "]="
+                             << inv_outgoing[cols[k]] << endl;
+                    }
+                }
+            }
+            run_parallel(num_threads, [&](unsigned int t) {
+                for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+                    size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+                    double b_diff = 0, b_sum = 0, b_dangling = 0;
+                    for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                        /* The element of the H multiplication */
+                        double h = 0.0;
+                        const Index *ci; // current incoming
+                        const Index *row_end =
+                            cols.data() + row_offsets[i + 1];
+                        for (ci = cols.data() + row_offsets[i]; ci != row_end;
+                             ci++) {
+                            h += out_pr[*ci];
+                        }
+                        h *= alpha;
+                        cur_pr[i] = h + one_Av + one_Iv;
+                        b_diff += fabs(cur_pr[i] - old_pr[i]);
+                        b_sum += cur_pr[i];
+                        if (num_outgoing[i] == 0) {
+                            b_dangling += cur_pr[i];
+                        }
+                    }
+                    block_diff[b] = b_diff;
+                    block_sum[b] = b_sum;
+                    block_dangling[b] = b_dangling;
+                }
+            });
+        }
+
+        /* The difference to be checked for convergence */
+        diff = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            diff += block_diff[b];
+        }
+        num_iterations++;
+        if (trace) {
+            pr.assign(cur_pr.begin(), cur_pr.end());
+            cout << num_iterations << ": ";
+            print_pagerank();
+        }
+
+        if (!extrapolating) {
+            continue;
+        }
+        since_extrapolation++;
+        if (since_extrapolation + 2 == extrapolation_period) {
+            hist3 = old_pr;
+        } else if (since_extrapolation + 1 == extrapolation_period) {
+            hist2 = old_pr;
+        } else if (since_extrapolation >= extrapolation_period
+                   && diff > convergence
+                   && num_iterations < max_iterations) {
+            /*
+             * Only extrapolate if there will be a power iteration after
+             * it, so that the result is always checked for convergence.
+             */
+            since_extrapolation = 0;
+            record_savings();
+            if (extrapolate(cur_pr, old_pr, hist2, hist3, bounds)) {
+                extrapolated_at = num_iterations;
+                extrapolated_diff = diff;
+                run_parallel(num_threads, [&](unsigned int t) {
+                    for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+                        size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+                        double b_sum = 0, b_dangling = 0;
+                        for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                            b_sum += cur_pr[i];
+                            if (num_outgoing[i] == 0) {
+                                b_dangling += cur_pr[i];
+                            }
+                        }
+                        block_sum[b] = b_sum;
+                        block_dangling[b] = b_dangling;
+                    }
+                });
+            }
+        }
+    }
+    record_savings();
+
+    pr.assign(cur_pr.begin(), cur_pr.end());
+}
+
+template <class Index, class Value>
+void Table::core_iterate(const vector<Index> &cols) {
+
+    double diff = 1;
+    size_t num_rows = num_outgoing.size();
+    const size_t NONE = numeric_limits<size_t>::max();
+
+    /*
+     * The core vertices, with both incoming and outgoing links, in
+     * order, and the index in the core of each vertex, NONE for the
+     * trivial ones.
+     */
+    vector<size_t> core;
+    vector<size_t> core_index(num_rows, NONE);
+    num_unreferenced = 0;
+    num_dangling = 0;
+    size_t num_isolated = 0; // vertices without any links
+    for (size_t i = 0; i < num_rows; i++) {
+        bool unreferenced = row_offsets[i] == row_offsets[i + 1];
+        bool dangling = num_outgoing[i] == 0;
+        num_unreferenced += unreferenced;
+        num_dangling += dangling;
+        num_isolated += unreferenced && dangling;
+        if (!unreferenced && !dangling) {
+            core_index[i] = core.size();
+            core.push_back(i);
+        }
+    }
+    size_t num_core = core.size();
+
+    /*
+     * The rows of the core, holding the arcs from core vertices, and the
+     * shares of the unreferenced vertices in each row, per unit of their
+     * common pagerank. Every source of an arc is either a core vertex or
+     * an unreferenced one.
+     */
+    vector<size_t> core_offsets(num_core + 1, 0);
+    for (size_t c = 0; c < num_core; c++) {
+        size_t i = core[c];
+        size_t length = 0;
+        for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+            length += core_index[cols[k]] != NONE;
+        }
+        core_offsets[c + 1] = core_offsets[c] + length;
+    }
+    vector<Index> core_cols(core_offsets[num_core]);
+    vector<double> unreferenced_share(num_core);
+    vector<size_t> core_bounds;
+    partition_blocks(core_offsets, core_bounds);
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = min(core_bounds[t] * BLOCK_ROWS, num_core);
+        size_t last = min(core_bounds[t + 1] * BLOCK_ROWS, num_core);
+        for (size_t c = first; c < last; c++) {
+            size_t i = core[c];
+            Index *row = core_cols.data() + core_offsets[c];
+            double share = 0;
+            for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+                if (core_index[cols[k]] != NONE) {
+                    *row++ = core_index[cols[k]];
+                } else {
+                    share += inv_outgoing[cols[k]];
+                }
+            }
+            unreferenced_share[c] = share;
+        }
+    });
+
+    /*
+     * The shares of each core vertex, per unit of its pagerank, that go
+     * to dangling vertices, and the sum of those of the unreferenced
+     * vertices, which make up the pagerank of the dangling vertices.
+     */
+    vector<double> dangling_share(num_core, 0);
+    double unreferenced_dangling_share = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        if (num_outgoing[i] > 0) {
+            continue;
+        }
+        for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+            if (core_index[cols[k]] != NONE) {
+                dangling_share[core_index[cols[k]]] += inv_outgoing[cols[k]];
+            } else {
+                unreferenced_dangling_share += inv_outgoing[cols[k]];
+            }
+        }
+    }
+
+    /* Per block sums of the core and of the whole graph */
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    size_t num_core_blocks = (num_core + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    vector<double> block_diff(max(num_blocks, num_core_blocks));
+    vector<double> block_sum(max(num_blocks, num_core_blocks));
+    vector<double> block_dangling(max(num_blocks, num_core_blocks));
+    vector<size_t> bounds;
+    partition_blocks(bounds);
+
+    /*
+     * The first iteration, from a start vector in which the unreferenced
+     * vertices may differ, goes over the whole graph. The new pagerank
+     * of the dangling vertices, which link to none, replaces their start
+     * value in pr; that of the core goes to cur_pr.
+     */
+    vector<Value> cur_pr(num_core);
+    vector<Value> old_pr(num_core);
+    vector<Value> out_pr(num_core);
+    double dangling_pr = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        if (num_outgoing[i] == 0) {
+            dangling_pr += pr[i];
+        }
+    }
+    /* The pagerank of the unreferenced vertices, from the constant terms */
+    double base_pr = alpha * dangling_pr / num_rows + (1 - alpha) / num_rows;
+    run_parallel(num_threads, [&](unsigned int t) {
+        for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+            size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+            double b_diff = 0, b_sum = 0, b_dangling = 0;
+            for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                double h = 0.0;
+                for (size_t k = row_offsets[i]; k < row_offsets[i + 1];
+                     k++) {
+                    h += (Value) (inv_outgoing[cols[k]] * pr[cols[k]]);
+                }
+                Value new_pr = alpha * h + base_pr;
+                b_diff += fabs(new_pr - pr[i]);
+                if (core_index[i] != NONE) {
+                    old_pr[core_index[i]] = pr[i];
+                    cur_pr[core_index[i]] = new_pr;
+                    b_sum += new_pr;
+                } else if (num_outgoing[i] == 0) {
+                    pr[i] = new_pr;
+                    b_dangling += new_pr;
+                }
+            }
+            block_diff[b] = b_diff;
+            block_sum[b] = b_sum;
+            block_dangling[b] = b_dangling;
+        }
+    });
+    diff = 0;
+    double core_pr = 0;
+    dangling_pr = 0;
+    for (size_t b = 0; b < num_blocks; b++) {
+        diff += block_diff[b];
+        core_pr += block_sum[b];
+        dangling_pr += block_dangling[b];
+    }
+    num_iterations++;
+
+    /*
+     * The pagerank of each unreferenced vertex in cur_pr, and in old_pr
+     * and the one before it, normalised; the last is only known after
+     * an iteration over the core.
+     */
+    double unreferenced_pr = base_pr;
+    double old_unreferenced_pr = 0;
+    double prev_unreferenced_pr = 0;
+    bool iterated = false;
+
+    while (diff > convergence && num_iterations < max_iterations) {
+
+        double sum_pr = core_pr + dangling_pr
+            + (num_unreferenced - num_isolated) * unreferenced_pr;
+
+        /*
+         * Normalize, and add up the pagerank that the core passes to the
+         * dangling vertices and how much it has changed.
+         */
+        run_parallel(num_threads, [&](unsigned int t) {
+            for (size_t b = core_bounds[t]; b < core_bounds[t + 1]; b++) {
+                size_t last = min((b + 1) * BLOCK_ROWS, num_core);
+                double b_change = 0, b_dangling = 0;
+                for (size_t c = b * BLOCK_ROWS; c < last; c++) {
+                    Value new_old = cur_pr[c] / sum_pr;
+                    b_change += dangling_share[c] * fabs(new_old - old_pr[c]);
+                    b_dangling += dangling_share[c] * new_old;
+                    old_pr[c] = new_old;
+                    out_pr[c] = inv_outgoing[core[c]] * new_old;
+                }
+                block_diff[b] = b_change;
+                block_dangling[b] = b_dangling;
+            }
+        });
+        double dangling_change = 0, to_dangling = 0;
+        for (size_t b = 0; b < num_core_blocks; b++) {
+            dangling_change += block_diff[b];
+            to_dangling += block_dangling[b];
+        }
+        prev_unreferenced_pr = old_unreferenced_pr;
+        old_unreferenced_pr = unreferenced_pr / sum_pr;
+        double old_dangling_pr = dangling_pr / sum_pr;
+
+        /* The elements of the A x I and 1 x I vectors, together */
+        base_pr = alpha * old_dangling_pr / num_rows + (1 - alpha) / num_rows;
+
+        run_parallel(num_threads, [&](unsigned int t) {
+            for (size_t b = core_bounds[t]; b < core_bounds[t + 1]; b++) {
+                size_t last = min((b + 1) * BLOCK_ROWS, num_core);
+                double b_diff = 0, b_sum = 0;
+                for (size_t c = b * BLOCK_ROWS; c < last; c++) {
+                    double h = unreferenced_share[c] * old_unreferenced_pr;
+                    const Index *ci; // current incoming
+                    const Index *row_end =
+                        core_cols.data() + core_offsets[c + 1];
+                    for (ci = core_cols.data() + core_offsets[c];
+                         ci != row_end; ci++) {
+                        h += out_pr[*ci];
+                    }
+                    cur_pr[c] = alpha * h + base_pr;
+                    b_diff += fabs(cur_pr[c] - old_pr[c]);
+                    b_sum += cur_pr[c];
+                }
+                block_diff[b] = b_diff;
+                block_sum[b] = b_sum;
+            }
+        });
+        diff = 0;
+        core_pr = 0;
+        for (size_t b = 0; b < num_core_blocks; b++) {
+            diff += block_diff[b];
+            core_pr += block_sum[b];
+        }
+        unreferenced_pr = base_pr;
+        dangling_pr = alpha * (to_dangling + unreferenced_dangling_share
+                               * old_unreferenced_pr)
+            + num_dangling * base_pr;
+
+        /*
+         * The difference of the unreferenced vertices is known; that of
+         * the dangling vertices with incoming links is at most the sum
+         * of their pagerank before and after. After the first iteration
+         * over the core, when both iterates come from the same
+         * unreferenced pagerank, it is also at most alpha times the
+         * changes of the shares they get, plus the change of the
+         * constant terms.
+         */
+        diff += num_unreferenced * fabs(unreferenced_pr - old_unreferenced_pr);
+        double dangling_diff =
+            (dangling_pr - num_isolated * unreferenced_pr)
+            + (old_dangling_pr - num_isolated * old_unreferenced_pr);
+        if (iterated) {
+            dangling_diff = min(dangling_diff, alpha * (dangling_change
+                + unreferenced_dangling_share
+                * fabs(old_unreferenced_pr - prev_unreferenced_pr))
+                + (num_dangling - num_isolated)
+                * fabs(unreferenced_pr - old_unreferenced_pr));
+        }
+        diff += dangling_diff;
+        iterated = true;
+        num_iterations++;
+    }
+
+    /*
+     * The pagerank vector: the dangling vertices get theirs from the
+     * last normalised iterate, unless the first iteration was the last.
+     */
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+        size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+        for (size_t i = first; i < last; i++) {
+            if (core_index[i] != NONE) {
+                pr[i] = cur_pr[core_index[i]];
+            } else if (row_offsets[i] == row_offsets[i + 1]) {
+                pr[i] = unreferenced_pr;
+            } else if (iterated) {
+                double h = 0.0;
+                for (size_t k = row_offsets[i]; k < row_offsets[i + 1];
+                     k++) {
+                    size_t c = core_index[cols[k]];
+                    h += (c != NONE)
+                        ? (double) out_pr[c]
+                        : (Value) (inv_outgoing[cols[k]]
+                                   * old_unreferenced_pr);
+                }
+                pr[i] = (Value) (alpha * h + base_pr);
+            }
+        }
+    });
+}
+
+template <class Index, class Value>
+void Table::adaptive_iterate(const vector<Index> &cols) {
+
+    double diff = 1;
+    size_t num_rows = num_outgoing.size();
+
+    /*
+     * The pagerank vector and the share of each element passed along
+     * each outgoing link. A frozen vertex keeps in cur_pr only the part
+     * of its pagerank that comes from its incoming links; the rest, the
+     * element of the A x I and 1 x I vectors, is the same for all the
+     * vertices and is added back to it with its current value.
+     */
+    vector<Value> cur_pr(pr.begin(), pr.end());
+    vector<Value> out_pr(num_rows);
+    vector<double>().swap(pr);
+    for (size_t i = 0; i < num_rows; i++) {
+        out_pr[i] = inv_outgoing[i] * cur_pr[i];
+    }
+    vector<unsigned char> frozen(num_rows, false);
+    vector<unsigned char> calm(num_rows, false);
+
+    /*
+     * The sums of the pagerank vector and of its dangling part over the
+     * active vertices, of the same over the incoming link parts of the
+     * frozen vertices, and the number of frozen vertices and of frozen
+     * dangling vertices.
+     */
+    double active_sum = 0, active_dangling = 0;
+    double frozen_sum = 0, frozen_dangling = 0;
+    size_t num_frozen = 0, num_frozen_dangling = 0;
+    for (size_t i = 0; i < num_rows; i++) {
+        active_sum += cur_pr[i];
+        if (num_outgoing[i] == 0) {
+            active_dangling += cur_pr[i];
+        }
+    }
+    double base_pr = 0;
+
+    /*
+     * The worklist: the vertices active when it was compacted, their
+     * rows with the arcs from the vertices active then, and for each row
+     * the shares of the incoming link parts of the vertices frozen then
+     * and the sum of their inverse outgoing links, by which the rest of
+     * their pagerank is passed along. Vertices frozen since keep their
+     * place and are skipped, and their shares are still read, as they
+     * were when they froze, from out_pr.
+     */
+    vector<size_t> work;
+    vector<size_t> work_offsets;
+    vector<Index> work_cols;
+    vector<double> frozen_in, frozen_inv;
+    vector<Value> new_pr;
+    vector<size_t> bounds;
+    size_t num_active = num_rows;
+    auto compact = [&]() {
+        vector<size_t> new_work;
+        new_work.reserve(num_active);
+        for (size_t i = 0; i < num_rows; i++) {
+            if (!frozen[i]) {
+                new_work.push_back(i);
+            }
+        }
+        work.swap(new_work);
+        vector<size_t>().swap(new_work);
+        size_t num_work = work.size();
+        work_offsets.assign(num_work + 1, 0);
+        for (size_t w = 0; w < num_work; w++) {
+            size_t i = work[w];
+            size_t length = 0;
+            for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+                length += !frozen[cols[k]];
+            }
+            work_offsets[w + 1] = work_offsets[w] + length;
+        }
+        vector<Index>(work_offsets[num_work]).swap(work_cols);
+        frozen_in.assign(num_work, 0);
+        frozen_inv.assign(num_work, 0);
+        new_pr.resize(num_work);
+        partition_blocks(work_offsets, bounds);
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first = min(bounds[t] * BLOCK_ROWS, num_work);
+            size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_work);
+            for (size_t w = first; w < last; w++) {
+                size_t i = work[w];
+                Index *row = work_cols.data() + work_offsets[w];
+                double h = 0, inv = 0;
+                for (size_t k = row_offsets[i]; k < row_offsets[i + 1];
+                     k++) {
+                    if (frozen[cols[k]]) {
+                        h += inv_outgoing[cols[k]] * cur_pr[cols[k]];
+                        inv += inv_outgoing[cols[k]];
+                    } else {
+                        *row++ = cols[k];
+                    }
+                }
+                frozen_in[w] = h;
+                frozen_inv[w] = inv;
+            }
+        });
+    };
+    compact();
+
+    /* Makes all the vertices active again, with their whole pagerank */
+    auto thaw = [&]() {
+        for (size_t i = 0; i < num_rows; i++) {
+            if (frozen[i]) {
+                cur_pr[i] += base_pr;
+                out_pr[i] = inv_outgoing[i] * cur_pr[i];
+                frozen[i] = false;
+                calm[i] = false;
+            }
+        }
+        active_sum += frozen_sum + num_frozen * base_pr;
+        active_dangling += frozen_dangling + num_frozen_dangling * base_pr;
+        frozen_sum = 0;
+        frozen_dangling = 0;
+        num_frozen = 0;
+        num_frozen_dangling = 0;
+        num_active = num_rows;
+    };
+
+    /* Per block sums of the worklist */
+    vector<double> block_diff, block_sum, block_dangling;
+    vector<double> block_frozen_sum, block_frozen_dangling;
+    vector<size_t> block_frozen, block_frozen_num_dangling;
+
+    /* The tolerance goes down each time the vertices are thawed */
+    double tolerance = adaptive_tolerance;
+
+    active_sizes.clear();
+    while (diff > convergence && num_iterations < max_iterations) {
+
+        if (num_active < ADAPTIVE_COMPACTION * work.size()) {
+            compact();
+        }
+        bool all_active = num_active == num_rows;
+        size_t num_work = work.size();
+        size_t num_blocks = (num_work + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        block_diff.assign(num_blocks, 0);
+        block_sum.assign(num_blocks, 0);
+        block_dangling.assign(num_blocks, 0);
+        block_frozen_sum.assign(num_blocks, 0);
+        block_frozen_dangling.assign(num_blocks, 0);
+        block_frozen.assign(num_blocks, 0);
+        block_frozen_num_dangling.assign(num_blocks, 0);
+        active_sizes.push_back(num_active);
+
+        /* The elements of the A x I and 1 x I vectors, together */
+        double old_base_pr = base_pr;
+        double dangling_pr = active_dangling + frozen_dangling
+            + num_frozen_dangling * old_base_pr;
+        base_pr = alpha * dangling_pr / num_rows + (1 - alpha) / num_rows;
+
+        /* The new pagerank of the active vertices ... */
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first = min(bounds[t] * BLOCK_ROWS, num_work);
+            size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_work);
+            for (size_t w = first; w < last; w++) {
+                if (frozen[work[w]]) {
+                    continue;
+                }
+                double h = frozen_in[w] + frozen_inv[w] * old_base_pr;
+                const Index *ci; // current incoming
+                const Index *row_end = work_cols.data() + work_offsets[w + 1];
+                for (ci = work_cols.data() + work_offsets[w]; ci != row_end;
+                     ci++) {
+                    h += out_pr[*ci];
+                }
+                new_pr[w] = alpha * h + base_pr;
+            }
+        });
+
+        /*
+         * ... replaces the old one once all are calculated, freezing the
+         * vertices that have converged.
+         */
+        run_parallel(num_threads, [&](unsigned int t) {
+            for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+                size_t last = min((b + 1) * BLOCK_ROWS, num_work);
+                for (size_t w = b * BLOCK_ROWS; w < last; w++) {
+                    size_t i = work[w];
+                    if (frozen[i]) {
+                        continue;
+                    }
+                    double delta = fabs((double) new_pr[w] - cur_pr[i]);
+                    double link_delta = fabs((double) new_pr[w] - base_pr
+                                             - cur_pr[i] + old_base_pr);
+                    out_pr[i] = inv_outgoing[i] * new_pr[w];
+                    block_diff[b] += delta;
+                    bool dangling = num_outgoing[i] == 0;
+                    if (link_delta > tolerance * new_pr[w]) {
+                        calm[i] = false;
+                    } else if (!calm[i]) {
+                        calm[i] = true;
+                    } else {
+                        cur_pr[i] = new_pr[w] - base_pr;
+                        frozen[i] = true;
+                        block_frozen[b]++;
+                        block_frozen_sum[b] += cur_pr[i];
+                        if (dangling) {
+                            block_frozen_dangling[b] += cur_pr[i];
+                            block_frozen_num_dangling[b]++;
+                        }
+                        continue;
+                    }
+                    cur_pr[i] = new_pr[w];
+                    block_sum[b] += new_pr[w];
+                    if (dangling) {
+                        block_dangling[b] += new_pr[w];
+                    }
+                }
+            }
+        });
+
+        diff = 0;
+        active_sum = 0;
+        active_dangling = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            diff += block_diff[b];
+            active_sum += block_sum[b];
+            active_dangling += block_dangling[b];
+            frozen_sum += block_frozen_sum[b];
+            frozen_dangling += block_frozen_dangling[b];
+            num_frozen += block_frozen[b];
+            num_frozen_dangling += block_frozen_num_dangling[b];
+            num_active -= block_frozen[b];
+        }
+        num_iterations++;
+        if (trace) {
+            pr.resize(num_rows);
+            for (size_t i = 0; i < num_rows; i++) {
+                pr[i] = cur_pr[i] + ((frozen[i]) ? base_pr : 0);
+            }
+            cout << num_iterations << ": ";
+            print_pagerank();
+        }
+
+        /*
+         * The frozen vertices may have drifted from the rest, so the
+         * iterations only stop once an iteration over all the vertices
+         * has converged; until then they are thawed and go on, freezing
+         * again at a tenth of the tolerance.
+         */
+        if (diff <= convergence && !all_active) {
+            thaw();
+            compact();
+            tolerance /= ADAPTIVE_TIGHTENING;
+            diff = numeric_limits<double>::max();
+        }
+    }
+
+    thaw();
+    pr.resize(num_rows);
+    for (size_t i = 0; i < num_rows; i++) {
+        pr[i] = cur_pr[i] / active_sum;
+    }
+}
+
+template <class Index>
+void Table::build_bins(const vector<Index> &out_cols, Bins<Index> &bins) {
+
+    size_t num_rows = num_outgoing.size();
+    unsigned int n = num_threads;
+
+    bins.shift = 0;
+    while (((size_t) 1 << bins.shift) < bin_width) {
+        bins.shift++;
+    }
+    bins.num_bins = (num_rows + bin_width - 1) >> bins.shift;
+
+    /* Split the sources among the threads by their outgoing arcs */
+    size_t num_arcs = out_row_offsets[num_rows];
+    bins.source_bounds.assign(n + 1, num_rows);
+    bins.source_bounds[0] = 0;
+    for (unsigned int t = 1; t < n; t++) {
+        size_t target = num_arcs / n * t + num_arcs % n * t / n;
+        bins.source_bounds[t] = max(bins.source_bounds[t - 1],
+            (size_t) (lower_bound(out_row_offsets.begin(),
+                                  out_row_offsets.end() - 1, target)
+                      - out_row_offsets.begin()));
+    }
+
+    /*
+     * Count the contributions of each thread to each bin, shifted by
+     * one, so that their prefix sums give the start of each part; the
+     * threads count different parts.
+     */
+    bins.starts.assign(bins.num_bins * n + 1, 0);
+    run_parallel(n, [&](unsigned int t) {
+        for (size_t u = bins.source_bounds[t];
+             u < bins.source_bounds[t + 1]; u++) {
+            for (size_t a = out_row_offsets[u]; a < out_row_offsets[u + 1];
+                 a++) {
+                bins.starts[(out_cols[a] >> bins.shift) * n + t + 1]++;
+            }
+        }
+    });
+    for (size_t k = 0; k < bins.num_bins * n; k++) {
+        bins.starts[k + 1] += bins.starts[k];
+    }
+
+    /* The destinations, in the order the contributions will be written */
+    bins.dests.resize(num_arcs);
+    run_parallel(n, [&](unsigned int t) {
+        vector<size_t> next(bins.num_bins);
+        for (size_t b = 0; b < bins.num_bins; b++) {
+            next[b] = bins.starts[b * n + t];
+        }
+        for (size_t u = bins.source_bounds[t];
+             u < bins.source_bounds[t + 1]; u++) {
+            for (size_t a = out_row_offsets[u]; a < out_row_offsets[u + 1];
+                 a++) {
+                bins.dests[next[out_cols[a] >> bins.shift]++] = out_cols[a];
+            }
+        }
+    });
+}
+
+template <class Index, class Value>
+void Table::bin_multiply(const vector<Index> &out_cols,
+                         const Bins<Index> &bins, vector<Value> &values,
+                         const vector<Value> &out_pr,
+                         const vector<Value> &old_pr, vector<Value> &cur_pr,
+                         double one_Av, double one_Iv,
+                         vector<double> &block_diff,
+                         vector<double> &block_sum,
+                         vector<double> &block_dangling) {
+
+    size_t num_rows = num_outgoing.size();
+    unsigned int n = num_threads;
+    values.resize(bins.dests.size());
+
+    /* Write the share of each source into the bins of its arcs ... */
+    run_parallel(n, [&](unsigned int t) {
+        vector<size_t> next(bins.num_bins);
+        for (size_t b = 0; b < bins.num_bins; b++) {
+            next[b] = bins.starts[b * n + t];
+        }
+        for (size_t u = bins.source_bounds[t];
+             u < bins.source_bounds[t + 1]; u++) {
+            Value share = out_pr[u];
+            for (size_t a = out_row_offsets[u]; a < out_row_offsets[u + 1];
+                 a++) {
+                values[next[out_cols[a] >> bins.shift]++] = share;
+            }
+        }
+    });
+
+    /*
+     * ... and add them up, bin by bin; the parts of the threads hold
+     * increasing sources, so the shares reach each destination in the
+     * order of the sources, as in the row kernel.
+     */
+    size_t width = (size_t) 1 << bins.shift;
+    run_parallel(n, [&](unsigned int t) {
+        vector<double> h(width);
+        for (size_t b = bins.num_bins * t / n;
+             b < bins.num_bins * (t + 1) / n; b++) {
+            size_t first = b << bins.shift;
+            size_t last = min(first + width, num_rows);
+            fill(h.begin(), h.end(), 0.0);
+            for (size_t k = bins.starts[b * n];
+                 k < bins.starts[(b + 1) * n]; k++) {
+                h[bins.dests[k] - first] += values[k];
+            }
+            for (size_t block = first / BLOCK_ROWS;
+                 block * BLOCK_ROWS < last; block++) {
+                size_t block_last = min((block + 1) * BLOCK_ROWS, last);
+                double b_diff = 0, b_sum = 0, b_dangling = 0;
+                for (size_t i = block * BLOCK_ROWS; i < block_last; i++) {
+                    double hi = h[i - first] * alpha;
+                    cur_pr[i] = hi + one_Av + one_Iv;
+                    b_diff += fabs(cur_pr[i] - old_pr[i]);
+                    b_sum += cur_pr[i];
+                    if (num_outgoing[i] == 0) {
+                        b_dangling += cur_pr[i];
+                    }
+                }
+                block_diff[block] = b_diff;
+                block_sum[block] = b_sum;
+                block_dangling[block] = b_dangling;
+            }
+        }
+    });
+}
+
+template <class Value>
+bool Table::extrapolate(vector<Value> &cur_pr, const vector<Value> &old_pr,
+                        const vector<Value> &hist2,
+                        const vector<Value> &hist3,
+                        const vector<size_t> &bounds) {
+
+    size_t num_rows = cur_pr.size();
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+    /*
+     * Runs f(i) on every element, with the blocks split among the
+     * threads as in the iterations.
+     */
+    auto for_all = [&](auto f) {
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+            size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+            for (size_t i = first; i < last; i++) {
+                f(i);
+            }
+        });
+    };
+
+    if (extrapolation == EXTRAPOLATION_AITKEN) {
+        /*
+         * Each element is extrapolated on its own from its last three
+         * values, x2, x1 and x0, as x0 - (x0 - x1)^2 / (x0 - 2 x1 + x2).
+         */
+        for_all([&](size_t i) {
+            double g = (double) cur_pr[i] - old_pr[i];
+            double h = g - ((double) old_pr[i] - hist2[i]);
+            if (h != 0) {
+                double x = cur_pr[i] - g * g / h;
+                if (x > 0 && isfinite(x)) {
+                    cur_pr[i] = x;
+                }
+            }
+        });
+        return true;
+    }
+
+    /*
+     * Quadratic extrapolation: with y1, y2 and y3 the differences of
+     * hist2, old_pr and cur_pr from hist3, find the least squares
+     * solution of y1 g1 + y2 g2 = -y3, and combine the last three
+     * iterates in proportion to g1 + g2 + 1, g2 + 1 and 1. The least squares
+     * problem is solved by orthogonalising y2 against y1, which needs a
+     * second pass over the vectors but keeps its accuracy when y1 and y2
+     * are almost parallel, as they are close to convergence. The dot
+     * products are summed per block and then in block order, so the
+     * result does not depend on the number of threads.
+     */
+    vector<double> dots(num_blocks * 3);
+    auto sum_dots = [&](double &d0, double &d1, double &d2) {
+        d0 = d1 = d2 = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            d0 += dots[b * 3];
+            d1 += dots[b * 3 + 1];
+            d2 += dots[b * 3 + 2];
+        }
+    };
+
+    /* The dot products of y1 with itself, y2 and y3 */
+    run_parallel(num_threads, [&](unsigned int t) {
+        for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+            size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+            double d11 = 0, d12 = 0, d13 = 0;
+            for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                double y1 = (double) hist2[i] - hist3[i];
+                d11 += y1 * y1;
+                d12 += y1 * ((double) old_pr[i] - hist3[i]);
+                d13 += y1 * ((double) cur_pr[i] - hist3[i]);
+            }
+            dots[b * 3] = d11;
+            dots[b * 3 + 1] = d12;
+            dots[b * 3 + 2] = d13;
+        }
+    });
+    double d11, d12, d13;
+    sum_dots(d11, d12, d13);
+    if (d11 == 0) {
+        return false;
+    }
+    double mu = d12 / d11;
+
+    /* The dot products of v = y2 - mu y1 with itself and y3 */
+    run_parallel(num_threads, [&](unsigned int t) {
+        for (size_t b = bounds[t]; b < bounds[t + 1]; b++) {
+            size_t last = min((b + 1) * BLOCK_ROWS, num_rows);
+            double dvv = 0, dv3 = 0;
+            for (size_t i = b * BLOCK_ROWS; i < last; i++) {
+                double y1 = (double) hist2[i] - hist3[i];
+                double v = ((double) old_pr[i] - hist3[i]) - mu * y1;
+                dvv += v * v;
+                dv3 += v * ((double) cur_pr[i] - hist3[i]);
+            }
+            dots[b * 3] = dvv;
+            dots[b * 3 + 1] = dv3;
+            dots[b * 3 + 2] = 0;
+        }
+    });
+    double dvv, dv3, unused;
+    sum_dots(dvv, dv3, unused);
+    if (dvv == 0) {
+        return false;
+    }
+    double g2 = -dv3 / dvv;
+    double g1 = -d13 / d11 - g2 * mu;
+
+    /*
+     * The weights are scaled to sum to one, so that the extrapolated
+     * elements are on the same scale as the ones left unchanged.
+     */
+    double scale = (g1 + g2 + 1) + (g2 + 1) + 1;
+    if (!isfinite(scale) || scale <= 0) {
+        return false;
+    }
+    double b0 = (g1 + g2 + 1) / scale;
+    double b1 = (g2 + 1) / scale;
+    double b2 = 1 / scale;
+
+    for_all([&](size_t i) {
+        double x = b0 * hist2[i] + b1 * old_pr[i] + b2 * cur_pr[i];
+        if (x > 0) {
+            cur_pr[i] = x;
+        }
+    });
+    return true;
+}
+
+template <class Index, class Value>
+void Table::gauss_seidel(const vector<Index> &cols) {
+
+    double diff = 1;
+    size_t num_rows = num_outgoing.size();
+
+    /*
+     * The pagerank vector, updated in place, and the share of each
+     * element passed along each outgoing link, updated along with it.
+     */
+    vector<Value> cur_pr(pr.begin(), pr.end());
+    vector<Value> out_pr(num_rows);
+    vector<double>().swap(pr);
+
+    /*
+     * The sum of the pagerank vector elements, and of those for dangling
+     * nodes; they are kept up to date as the elements change.
+     */
+    double sum_pr = 0;
+    double dangling_pr = 0;
+    for (size_t k = 0; k < num_rows; k++) {
+        sum_pr += cur_pr[k];
+        if (num_outgoing[k] == 0) {
+            dangling_pr += cur_pr[k];
+        }
+    }
+
+    while (diff > convergence && num_iterations < max_iterations) {
+
+        /* Normalize so that we start with sum equal to one */
+        for (size_t k = 0; k < num_rows; k++) {
+            cur_pr[k] = cur_pr[k] / sum_pr;
+            out_pr[k] = inv_outgoing[k] * cur_pr[k];
+        }
+        dangling_pr /= sum_pr;
+        sum_pr = 1;
+
+        /*
+         * Each element is calculated from the latest values of the
+         * others, including the ones already updated in this sweep.
+         * Sweeps alternate between ascending and descending order, so
+         * that updates propagate quickly along links in either
+         * direction.
+         */
+        diff = 0;
+        for (size_t r = 0; r < num_rows; r++) {
+            size_t i = (num_iterations % 2 == 0) ? r : num_rows - 1 - r;
+            /* The corresponding element of the H multiplication */
+            double h = 0.0;
+            const Index *ci; // current incoming
+            const Index *row_end = cols.data() + row_offsets[i + 1];
+            for (ci = cols.data() + row_offsets[i]; ci != row_end; ci++) {
+                h += out_pr[*ci];
+            }
+            h *= alpha;
+            /* The elements of the A x I and 1 x I vectors, as of now */
+            double one_Av = alpha * dangling_pr / num_rows;
+            double one_Iv = (1 - alpha) * sum_pr / num_rows;
+            Value new_pr = h + one_Av + one_Iv;
+            double delta = (double) new_pr - cur_pr[i];
+            diff += fabs(delta);
+            sum_pr += delta;
+            if (num_outgoing[i] == 0) {
+                dangling_pr += delta;
+            }
+            cur_pr[i] = new_pr;
+            out_pr[i] = inv_outgoing[i] * new_pr;
+        }
+
+        num_iterations++;
+        if (trace) {
+            pr.assign(cur_pr.begin(), cur_pr.end());
+            cout << num_iterations << ": ";
+            print_pagerank();
+        }
+    }
+
+    /* Normalize the final sweep as well */
+    pr.resize(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        pr[k] = cur_pr[k] / sum_pr;
+    }
+}
+
+const void Table::print_params(ostream& out) {
+    out << "alpha = " << alpha << " convergence = " << convergence
+        << " max_iterations = " << max_iterations
+        << " numeric = " << numeric
+        << " delimiter = '" << delim << "'"
+        << " threads = " << num_threads
+        << " float = " << single_precision
+        << " solver = " << get_solver_name()
+        << " extrapolation = " << get_extrapolation_name();
+    if (extrapolation != EXTRAPOLATION_NONE) {
+        out << " every " << extrapolation_period;
+    }
+    if (bin_width > 0) {
+        out << " bin_width = " << bin_width;
+    }
+    if (skip_trivial) {
+        out << " skip_trivial = " << skip_trivial;
+    }
+    if (adaptive_tolerance > 0) {
+        out << " adaptive_tolerance = " << adaptive_tolerance;
+    }
+    if (num_processes > 1) {
+        out << " processes = " << num_processes;
+    }
+    if (!rendezvous.empty()) {
+        out << " worker = " << worker << " rendezvous = " << rendezvous;
+    }
+    out << endl;
+}
+
+const void Table::print_table() {
+
+    finalize();
+
+    size_t num_rows = num_outgoing.size();
+    for (size_t i = 0; i < num_rows; i++) {
+        cout << original_index(i) << ":[ ";
+        for (size_t k = row_offsets[i]; k < row_offsets[i + 1]; k++) {
+            size_t cc = original_index(get_col_index(k)); // current column
+            if (numeric) {
+                cout << cc << " ";
+            } else {
+                cout << names.name(cc) << " ";
+            }
+        }
+        cout << "]" << endl;
+    }
+}
+
+const void Table::print_outgoing() {
+    vector<size_t>::iterator cn;
+
+    cout << "[ ";
+    for (cn = num_outgoing.begin(); cn != num_outgoing.end(); cn++) {
+        cout << *cn << " ";
+    }
+    cout << "]" << endl;
+
+}
+
+const void Table::print_pagerank() {
+
+    vector<double>::iterator cr;
+    double sum = 0;
+
+    cout.precision(numeric_limits<double>::digits10);
+    
+    cout << "(" << pr.size() << ") " << "[ ";
+    for (cr = pr.begin(); cr != pr.end(); cr++) {
+        cout << *cr << " ";
+        sum += *cr;
         cout << "s = " << sum << " ";
     }
     cout << "] "<< sum << endl;
 }
 
+void Table::format_pagerank(size_t first, size_t last, string &out) {
+
+    out.clear();
+    for (size_t i = first; i < last; i++) {
+        format_line(i, pr[i], out);
+    }
+}
+
+void Table::format_line(size_t i, double value, string &out) {
+
+    char num[32]; // enough for any size_t or double
+    char *num_end;
+
+    if (!numeric) {
+        out.append(names.name(i));
+    } else {
+        num_end = to_chars(num, num + sizeof(num), i).ptr;
+        out.append(num, num_end - num);
+    }
+    out.append(" = ");
+    num_end = to_chars(num, num + sizeof(num), value).ptr;
+    out.append(num, num_end - num);
+    out.push_back('\n');
+}
+
 const void Table::print_pagerank_v() {
 
-    size_t i;
     size_t num_rows = pr.size();
     double sum = 0;
-    
-    cout.precision(numeric_limits<double>::digits10);
+    vector<string> buffers(num_threads);
+
+    cout.flush();
+    for (size_t first = 0; first < num_rows;
+         first += num_threads * OUTPUT_CHUNK) {
+        run_parallel(num_threads, [&](unsigned int t) {
+            size_t chunk_first = min(first + t * OUTPUT_CHUNK, num_rows);
+            size_t chunk_last = min(chunk_first + OUTPUT_CHUNK, num_rows);
+            format_pagerank(chunk_first, chunk_last, buffers[t]);
+        });
+        for (unsigned int t = 0; t < num_threads; t++) {
+            cout.write(buffers[t].data(), buffers[t].size());
+        }
+    }
+    cout.flush();
 
-    for (i = 0; i < num_rows; i++) {
-        if (!numeric) {
-            cout << idx_to_nodes[i] << " = " << pr[i] << endl;
-        } else {
-            cout << i << " = " << pr[i] << endl;
+    for (size_t i = 0; i < num_rows; i++) {
+        sum += pr[i];
+    }
+    cerr << "s = " << sum << " " << endl;
+}
+
+void Table::top_pagerank(size_t k, vector<size_t> &top) {
+
+    size_t num_rows = pr.size();
+    k = min(k, num_rows);
+
+    /* Vertex a ranks before vertex b; ties go to the lower index */
+    auto before = [&](size_t a, size_t b) {
+        return pr[a] > pr[b] || (pr[a] == pr[b] && a < b);
+    };
+
+    /*
+     * Each thread keeps the k best vertices of its part of the vector in
+     * a heap whose top is the worst of them.
+     */
+    vector< vector<size_t> > heaps(num_threads);
+    run_parallel(num_threads, [&](unsigned int t) {
+        vector<size_t> &heap = heaps[t];
+        size_t first = num_rows / num_threads * t
+            + num_rows % num_threads * t / num_threads;
+        size_t last = num_rows / num_threads * (t + 1)
+            + num_rows % num_threads * (t + 1) / num_threads;
+        heap.reserve(k + 1);
+        for (size_t i = first; i < last && k > 0; i++) {
+            if (heap.size() < k) {
+                heap.push_back(i);
+                push_heap(heap.begin(), heap.end(), before);
+            } else if (before(i, heap.front())) {
+                pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = i;
+                push_heap(heap.begin(), heap.end(), before);
+            }
         }
+    });
+
+    /* Only the candidates of the threads need to be sorted */
+    top.clear();
+    for (unsigned int t = 0; t < num_threads; t++) {
+        top.insert(top.end(), heaps[t].begin(), heaps[t].end());
+    }
+    partial_sort(top.begin(), top.begin() + k, top.end(), before);
+    top.resize(k);
+}
+
+const void Table::print_pagerank_top(size_t k) {
+
+    vector<size_t> top;
+    string out;
+    double sum = 0;
+
+    top_pagerank(k, top);
+    for (size_t r = 0; r < top.size(); r++) {
+        string line;
+        format_pagerank(top[r], top[r] + 1, line);
+        out.append(line);
+    }
+    cout.flush();
+    cout.write(out.data(), out.size());
+    cout.flush();
+
+    for (size_t i = 0; i < pr.size(); i++) {
         sum += pr[i];
     }
     cerr << "s = " << sum << " " << endl;
 }
+
+const void Table::print_pagerank_list(
+    const vector< pair<size_t, double> > &top) {
+
+    string out;
+    double sum = 0;
+
+    for (size_t r = 0; r < top.size(); r++) {
+        format_line(top[r].first, top[r].second, out);
+        sum += top[r].second;
+    }
+    cout.flush();
+    cout.write(out.data(), out.size());
+    cout.flush();
+    cerr << "s = " << sum << " " << endl;
+}
+
+const void Table::print_pagerank_b() {
+
+    size_t num_rows = pr.size();
+    double sum = 0;
+    vector<PagerankRecord> buffer;
+
+    cout.flush();
+    for (size_t first = 0; first < num_rows; first += OUTPUT_CHUNK) {
+        size_t last = min(first + OUTPUT_CHUNK, num_rows);
+        buffer.resize(last - first);
+        for (size_t i = first; i < last; i++) {
+            buffer[i - first].index = i;
+            buffer[i - first].pagerank = pr[i];
+            sum += pr[i];
+        }
+        cout.write((const char *) buffer.data(),
+                   buffer.size() * sizeof(PagerankRecord));
+    }
+    cout.flush();
+
+    cerr << "s = " << sum << " " << endl;
+}
@@ -32,11 +32,27 @@
    OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifndef TABLE_H
+#define TABLE_H
+
 #include <vector>
 #include <set>
 #include <map>
 #include <string>
+#include <string_view>
 #include <list>
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "dictionary.h"
+#include "csr.h"
+#include "update.h"
+#include "personalized.h"
+#include "push.h"
+#include "walks.h"
+#include "stream.h"
+#include "distributed.h"
 
 using namespace std;
 
@@ -45,6 +61,110 @@ const double DEFAULT_CONVERGENCE = 0.00001;
 const unsigned long DEFAULT_MAX_ITERATIONS = 10000;
 const bool DEFAULT_NUMERIC = false;
 const string DEFAULT_DELIM = " => ";
+const unsigned int DEFAULT_NUM_THREADS = 1;
+const unsigned int DEFAULT_NUM_PROCESSES = 1;
+const bool DEFAULT_SINGLE_PRECISION = false;
+
+/*
+ * The iterative methods for calculating the pagerank vector.
+ */
+enum Solver {
+    SOLVER_POWER, // the power method (Jacobi iterations)
+    SOLVER_GAUSS_SEIDEL, // Gauss-Seidel iterations, updating in place
+    NUM_SOLVERS
+};
+
+/* The names of the solvers, as given on the command line */
+const char * const SOLVER_NAMES[NUM_SOLVERS] = { "power", "gauss-seidel" };
+
+/*
+ * The extrapolation methods for accelerating the power method.
+ */
+enum Extrapolation {
+    EXTRAPOLATION_NONE, // plain power iterations
+    EXTRAPOLATION_AITKEN, // Aitken extrapolation, element by element
+    EXTRAPOLATION_QUADRATIC, // quadratic extrapolation
+    NUM_EXTRAPOLATIONS
+};
+
+/* The names of the extrapolation methods, as given on the command line */
+const char * const EXTRAPOLATION_NAMES[NUM_EXTRAPOLATIONS] = {
+    "none", "aitken", "quadratic"
+};
+
+/*
+ * The fewest power iterations between extrapolations for each method:
+ * quadratic extrapolation uses the last four iterates and Aitken
+ * extrapolation the last three.
+ */
+const unsigned long MIN_EXTRAPOLATION_PERIODS[NUM_EXTRAPOLATIONS] = {
+    1, 2, 3
+};
+
+/*
+ * The orderings of the vertices that reorder() can apply.
+ */
+enum Ordering {
+    ORDERING_DEGREE, // by decreasing number of outgoing links
+    ORDERING_RCM, // reverse Cuthill-McKee
+    ORDERING_GORDER, // greedy ordering by shared neighbours (Gorder)
+    NUM_ORDERINGS
+};
+
+/* The names of the orderings, as given on the command line */
+const char * const ORDERING_NAMES[NUM_ORDERINGS] = {
+    "degree", "rcm", "gorder"
+};
+
+/* The power iterations between extrapolations, by default */
+const unsigned long DEFAULT_EXTRAPOLATION_PERIOD = 10;
+
+/* The random walks started from each vertex by monte_carlo_pagerank() */
+const unsigned long DEFAULT_WALKS = 100;
+
+/*
+ * The destinations per bin of the propagation blocking kernel, by
+ * default; 0 selects the row kernel.
+ */
+const size_t DEFAULT_BIN_WIDTH = 0;
+
+/*
+ * The layout of the propagation blocking kernel of power_iterate(); see
+ * set_bin_width(). The destinations are split into bins of 1 << shift
+ * vertices, and the sources among the threads; the contributions of the
+ * sources of each thread to each bin are stored together, with the bins
+ * in order and the threads in order within each bin.
+ */
+template <class Index>
+struct Bins {
+    unsigned int shift; // log2 of the destinations per bin
+    size_t num_bins;
+    vector<size_t> source_bounds; // first source of each thread, and end
+    vector<size_t> starts; // start of the part of thread t in bin b, at
+                           // b * num_threads + t, and the end
+    vector<Index> dests; // destination of each contribution
+};
+
+/*
+ * The change of a vertex in an iteration, relative to its pagerank,
+ * below which the adaptive power method freezes it, by default; 0
+ * selects the plain power method.
+ */
+const double DEFAULT_ADAPTIVE_TOLERANCE = 0;
+
+/* The arcs sorted in memory at a time by build_snapshot(), by default */
+const size_t DEFAULT_RUN_ARCS = 1 << 24;
+
+/* The residual per outgoing arc below which local_pagerank() stops */
+const double DEFAULT_LOCAL_EPSILON = 1e-6;
+
+/*
+ * A record of the binary output of the pagerank vector.
+ */
+struct PagerankRecord {
+    uint64_t index; // the index of the vertex
+    double pagerank; // the pagerank of the vertex
+};
 
 /*
  * A PageRank calculator. It is responsible for reading data, performing
@@ -65,18 +185,110 @@ private:
     unsigned long max_iterations;
     string delim;
     bool numeric; // input graph has numeric, zero-based indexed vertices
+    unsigned int num_threads; // threads used for the calculations
+    unsigned int num_processes; // worker processes of the power method
+    unsigned int worker; // index of this process among independently
+                         // started workers
+    string rendezvous; // address at which they meet, empty if the
+                       // workers are forked instead
+    bool single_precision; // calculate with float instead of double values
+    bool force_wide_indices; // use 64 bit indices even if 32 bits suffice
+    Solver solver; // the iterative method used by pagerank()
+    unsigned long num_iterations; // iterations performed by pagerank()
+    unsigned long num_steps; // steps of the random walks performed by
+                             // monte_carlo_pagerank()
+    size_t bin_width; // destinations per bin of the propagation blocking
+                      // kernel, 0 for the row kernel
+    bool skip_trivial; // iterate only over vertices with both incoming
+                       // and outgoing links
+    double adaptive_tolerance; // relative change below which a vertex
+                               // is frozen, 0 for no freezing
+    vector<size_t> active_sizes; // vertices iterated over in each
+                                 // iteration of the adaptive method
+    size_t num_unreferenced; // vertices without incoming links, and ...
+    size_t num_dangling; // ... without outgoing ones, as last skipped
+    Extrapolation extrapolation; // accelerates the power method, if any
+    unsigned long extrapolation_period; // power iterations between
+                                        // extrapolations
+    vector< pair<unsigned long, double> > extrapolation_savings;
+                                // (iteration, power iterations saved)
+                                // for each extrapolation
     vector<size_t> num_outgoing; // number of outgoing links per column
-    vector< vector<size_t> > rows; // the rowns of the hyperlink matrix
-    map<string, size_t> nodes_to_idx; // mapping from string node IDs to numeric
-    map<size_t, string> idx_to_nodes; // mapping from numeric node IDs to string
+    vector< pair<size_t, size_t> > arcs; // (from, to) arcs as read, while
+                                         // the graph is being built
+    bool finalized; // arcs have been packed into the CSR arrays below
+    bool wide_indices; // the CSR column indices are in wide_col_indices
+    vector<size_t> row_offsets; // start of each row in the column indices
+    vector<uint32_t> col_indices; // incoming vertices of all rows, packed
+                                  // (CSR), for up to 2^32 - 1 vertices
+    vector<uint64_t> wide_col_indices; // the same, for larger graphs
+    vector<double> inv_outgoing; // reciprocal of num_outgoing, 0 if dangling
+    vector<size_t> order; // original index of each vertex, if reordered
+    Dictionary names; // mapping between string node IDs and numeric ones
     vector<double> pr; // the pagerank table
+    size_t run_arcs; // arcs sorted in memory at a time by build_snapshot()
+
+    /*
+     * The snapshot whose rows pagerank() streams from disk, if the graph
+     * was opened with open_snapshot(), and the file positions of its row
+     * offsets, column indices and number of outgoing links; the rows are
+     * not kept in memory then.
+     */
+    string stream_filename;
+    uint64_t stream_offsets_pos;
+    uint64_t stream_cols_pos;
+    uint64_t stream_outgoing_pos;
+    vector<double> start_pr; // the vector pagerank() starts from, if read
+                             // with read_pagerank(string&)
+
+    vector<DeltaArc> delta_arcs; // changes waiting for update_pagerank()
+    vector<size_t> out_row_offsets; // start of each vertex's outgoing arcs
+    vector<uint32_t> out_col_indices; // destinations of the outgoing arcs
+                                      // of all vertices, packed (CSR)
+    vector<uint64_t> wide_out_col_indices; // the same, for larger graphs
+    IncrementalPagerank incremental; // kept by update_pagerank() between
+                                     // batches of changes
+    unsigned long num_pushes; // pushes by the last update_pagerank() or
+                              // local_pagerank()
+
+    vector<string> seed_set_names; // names of the personalization sets
+    vector< vector<size_t> > seed_sets; // the vertices of each set
+    unordered_map<string, size_t> seed_set_index; // index of each set name
+
+    LocalPush local_push; // answers local_pagerank() queries
+
+    /*
+     * Returns str without its leading and trailing \t and " " characters.
+     */
+    string_view trim(string_view str);
+
+    /*
+     * Returns the integer value of str, as strtol(3) would return it, but
+     * without requiring str to be null terminated.
+     */
+    size_t parse_index(string_view str);
+
+    /*
+     * Splits a line of the graph data file at the delimiter into the
+     * trimmed from and to fields. Returns false if the line does not
+     * contain the delimiter.
+     */
+    bool split_line(string_view line, string_view &from, string_view &to);
+
+    /*
+     * Adds the arc described by a line of the graph data file, if the line
+     * contains the delimiter, to the hyperlink matrix.
+     */
+    void read_line(string_view line);
 
     /*
-     * Trims leading and trailing \t and " " characters from str.
+     * Reads the graph data of the given size, split at line boundaries in
+     * as many chunks as there are threads, each of which is parsed by its
+     * own thread. The arcs are then merged in chunk order, so that the
+     * results are the same as reading the data sequentially. Returns the
+     * number of lines read.
      */
-    void trim(string &str);
-    template <class Vector, class T> bool insert_into_vector(Vector& v,
-                                                             const T& t);
+    size_t read_chunks(const char *data, size_t size);
 
     /*
      * Clears all internal data structures so that the table can be used
@@ -86,17 +298,239 @@ private:
     
     /*
      * Adds a mapping from a node string ID (key) to a numeric one to the
-     * internal mapping tables.
+     * dictionary of names.
      *
      * Returns the mapped value of the node; if the node has already
      * been mapped, the already mapped index.
      */
-    size_t insert_mapping(const string &key);
+    size_t insert_mapping(string_view key);
+
+    /*
+     * Adds an arc to the hyperlink matrix between from and to. The arc
+     * is appended to the arc buffer; duplicate arcs are removed when the
+     * buffer is packed by finalize().
+     */
+    void add_arc(size_t from, size_t to);
+
+    /*
+     * Splits the rows of the hyperlink matrix among the threads with
+     * partition_rows() (see csr.h).
+     */
+    void partition_blocks(vector<size_t> &bounds);
+
+    /*
+     * The same, for the rows whose starts are given by offsets.
+     */
+    void partition_blocks(const vector<size_t> &offsets,
+                          vector<size_t> &bounds);
+
+    /*
+     * Packs the buffered arcs into row_offsets and cols, as described in
+     * finalize(), and counts the outgoing links of each vertex.
+     */
+    template <class Index> void build_rows(vector<Index> &cols);
+
+    /*
+     * Returns the column index at position k of the packed rows.
+     */
+    size_t get_col_index(size_t k);
+
+    /*
+     * Performs the pagerank iterations on the packed rows in cols, with
+     * the calculations carried out on values of type Value; the sums
+     * over all the vertices are always taken in double precision. With
+     * a bin width, the propagation blocking kernel works on the outgoing
+     * arcs in out_cols, which are built if needed.
+     */
+    template <class Index, class Value>
+    void power_iterate(const vector<Index> &cols, vector<Index> &out_cols);
 
     /*
-     * Adds an arc to the hyperlink matrix between from and to.
+     * Lays out the bins of the propagation blocking kernel for the
+     * outgoing arcs in out_cols and the current threads and bin width.
      */
-    bool add_arc(size_t from, size_t to);
+    template <class Index>
+    void build_bins(const vector<Index> &out_cols, Bins<Index> &bins);
+
+    /*
+     * Calculates cur_pr from out_pr, the shares of the previous
+     * pagerank vector passed along each link, and the constant terms
+     * one_Av and one_Iv, by propagation blocking: the sources write
+     * their shares, in order, into the bins of the destinations of
+     * their arcs in values, and then the shares in each bin are added
+     * up in an array small enough to stay in the cache. The shares
+     * reach each destination in the order of the row kernel, so the
+     * results are the same. Fills the per block sums like the row
+     * kernel.
+     */
+    template <class Index, class Value>
+    void bin_multiply(const vector<Index> &out_cols, const Bins<Index> &bins,
+                      vector<Value> &values, const vector<Value> &out_pr,
+                      const vector<Value> &old_pr, vector<Value> &cur_pr,
+                      double one_Av, double one_Iv,
+                      vector<double> &block_diff, vector<double> &block_sum,
+                      vector<double> &block_dangling);
+
+    /*
+     * Extrapolates the pagerank vector cur_pr from it and the previous
+     * iterates old_pr, hist2 and hist3, with old_pr the most recent, as
+     * selected by extrapolation; only the first two previous iterates
+     * are used by Aitken extrapolation. The threads work on the blocks
+     * given by bounds, as returned by partition_blocks(). Elements
+     * whose extrapolated value is not positive are left as they are.
+     *
+     * Returns false, leaving cur_pr unchanged, if the iterates do not
+     * allow an extrapolation.
+     */
+    template <class Value>
+    bool extrapolate(vector<Value> &cur_pr, const vector<Value> &old_pr,
+                     const vector<Value> &hist2, const vector<Value> &hist3,
+                     const vector<size_t> &bounds);
+
+    /*
+     * Applies the sorted changes in delta, which hold at most one change
+     * per arc, to the packed rows in offsets and cols; rows are indexed
+     * by the source of each arc if by_source is true, and by its
+     * destination otherwise. The rows stay sorted, inserting an arc that
+     * already exists or deleting one that does not changes nothing, and
+     * rows up to the size of offsets, minus one, are added as needed.
+     */
+    template <class Index>
+    void merge_rows(vector<size_t> &offsets, vector<Index> &cols,
+                    const vector<DeltaArc> &delta, bool by_source);
+
+    /*
+     * Builds the outgoing arcs of each vertex, in out_row_offsets and
+     * out_cols, from the packed rows in cols.
+     */
+    template <class Index>
+    void build_out_rows(const vector<Index> &cols, vector<Index> &out_cols);
+
+    /*
+     * Fills new_order with the vertices by decreasing number of outgoing
+     * links, and by index among those with the same number.
+     */
+    void degree_order(vector<size_t> &new_order);
+
+    /*
+     * Fills new_order with the reverse Cuthill-McKee ordering of the
+     * graph, with arcs taken in both directions, from the packed rows in
+     * cols and the outgoing arcs in out_cols.
+     */
+    template <class Index>
+    void rcm_order(const vector<Index> &cols, const vector<Index> &out_cols,
+                   vector<size_t> &new_order);
+
+    /*
+     * Fills new_order with the greedy Gorder ordering of the graph, from
+     * the packed rows in cols and the outgoing arcs in out_cols; see
+     * reorder(Ordering).
+     */
+    template <class Index>
+    void gorder_order(const vector<Index> &cols, const vector<Index> &out_cols,
+                      vector<size_t> &new_order);
+
+    /*
+     * Orders the vertices as selected by o, building the outgoing arcs in
+     * out_cols if the ordering needs them, and renumbers them in the
+     * packed rows in cols; see reorder(Ordering).
+     */
+    template <class Index>
+    void reorder_rows(vector<Index> &cols, vector<Index> &out_cols,
+                      Ordering o);
+
+    /*
+     * Renumbers the vertices of the packed rows in cols, the number of
+     * outgoing links and their reciprocals so that vertex k becomes the
+     * one that was new_order[k], and adds the renumbering to order.
+     */
+    template <class Index>
+    void permute_rows(vector<Index> &cols, const vector<size_t> &new_order);
+
+    /*
+     * Returns the index that vertex k had before any reordering.
+     */
+    size_t original_index(size_t k);
+
+    /*
+     * Moves the elements of v, indexed by the vertices of the reordered
+     * graph, back to the original indices of the vertices.
+     */
+    void restore_order(vector<double> &v);
+
+    /*
+     * Returns the view of the packed rows in cols for the calculations
+     * outside of the table (see csr.h).
+     */
+    template <class Index>
+    Csr<Index> in_rows(const vector<Index> &cols);
+
+    /*
+     * The same, for the outgoing arcs in out_cols.
+     */
+    template <class Index>
+    Csr<Index> out_rows(const vector<Index> &out_cols);
+
+    /*
+     * Returns the settings of the iterations for the calculations
+     * outside of the table.
+     */
+    IterationSettings iteration_settings();
+
+    /*
+     * Applies delta_arcs to the packed rows in cols and the outgoing arcs
+     * in out_cols, starting the incremental state first if needed, and
+     * then pushes residuals until the pagerank vector is accurate
+     * enough; see update_pagerank().
+     */
+    template <class Index>
+    void apply_delta(vector<Index> &cols, vector<Index> &out_cols);
+
+    /*
+     * Calls the pagerank iterations of the selected solver; returns
+     * false if a worker process failed.
+     */
+    template <class Index, class Value>
+    bool iterate(const vector<Index> &cols, vector<Index> &out_cols);
+
+    /*
+     * Performs the power iterations of pagerank() on the packed rows in
+     * cols, iterating over the vertices with both incoming and outgoing
+     * links only; see set_skip_trivial().
+     */
+    template <class Index, class Value>
+    void core_iterate(const vector<Index> &cols);
+
+    /*
+     * Performs the power iterations of pagerank() on the packed rows in
+     * cols, freezing the vertices as they converge; see
+     * set_adaptive_tolerance().
+     */
+    template <class Index, class Value>
+    void adaptive_iterate(const vector<Index> &cols);
+
+    /*
+     * Performs Gauss-Seidel pagerank iterations on the packed rows in
+     * cols: each element of the pagerank vector is updated in place, so
+     * elements later in a sweep already use the updated values of the
+     * earlier ones; the dangling and teleportation terms are kept up to
+     * date with every update, and successive sweeps run in opposite
+     * directions. This usually needs considerably fewer iterations than
+     * the power method, but it runs on a single thread.
+     */
+    template <class Index, class Value>
+    void gauss_seidel(const vector<Index> &cols);
+
+    /*
+     * Formats the lines output by print_pagerank_v() for the vertices
+     * from first up to, but not including, last into out.
+     */
+    void format_pagerank(size_t first, size_t last, string &out);
+
+    /*
+     * Appends the line of vertex i with the given rank to out.
+     */
+    void format_line(size_t i, double value, string &out);
     
 public:
     Table(double a = DEFAULT_ALPHA, double c = DEFAULT_CONVERGENCE,
@@ -121,6 +555,11 @@ public:
      */
     const size_t get_num_rows();
 
+    /*
+     * Returns the number of links of the link matrix.
+     */
+    const size_t get_num_arcs();
+
     /*
      * Sets the number of rows of the link matrix.
      */
@@ -129,15 +568,342 @@ public:
     const void error(const char *p,const char *p2 = "");
 
     /*
-     * Reads the graph described in filename.
+     * Reads the graph described in filename. Regular files are mapped to
+     * memory and parsed in place, in parallel if more than one thread is
+     * used; if filename is empty, the graph is read from the standard
+     * input.
      */
     int read_file(const string &filename);
 
+    /*
+     * Writes the hyperlink matrix, the number of outgoing links of each
+     * vertex and, for string input, the mapping between vertex names and
+     * indices to a binary snapshot file, which can be read back with
+     * read_snapshot(string&) much faster than the original graph file.
+     */
+    int write_snapshot(const string &filename);
+
+    /*
+     * Reads a graph from a snapshot file written by
+     * write_snapshot(string&). Its arrays are read as they are, without
+     * any parsing or rebuilding.
+     * Whether the vertices are numeric is taken from the snapshot.
+     */
+    int read_snapshot(const string &filename);
+
+    /*
+     * Builds a snapshot file from the graph in graph_filename, like
+     * read_file(string&) followed by write_snapshot(string&), for graphs
+     * whose arcs do not fit in memory. The file is read sequentially,
+     * and every time the given number of arcs (see set_run_arcs()) has
+     * been read they are sorted and written to a temporary run file
+     * next to the snapshot; the runs are then merged into the rows of
+     * the snapshot. Only the vertex names, the number of outgoing links
+     * of each vertex and the row offsets are kept in memory. The table
+     * is empty afterwards; the snapshot can be read with
+     * read_snapshot(string&) or open_snapshot(string&).
+     */
+    int build_snapshot(const string &graph_filename,
+                       const string &filename);
+
+    /*
+     * Opens a snapshot file written by write_snapshot(string&) or
+     * build_snapshot() for semi-external calculations: only the number
+     * of outgoing links of each vertex and the vertex names are read
+     * into memory, and pagerank() streams the rows from the file in
+     * every iteration, in large sequential reads that overlap with the
+     * calculations; besides those, it only keeps two pagerank vectors
+     * in memory. The rows are sorted by destination, so the results are
+     * the same as those of the power method on the graph in memory.
+     * pagerank() stops with an error if the Gauss-Seidel solver, a bin
+     * width, extrapolation, skipping trivial vertices, an adaptive
+     * tolerance or more than one process is set; the other
+     * calculations, updates and write_snapshot() stop with an error on
+     * an opened snapshot.
+     */
+    int open_snapshot(const string &filename);
+
+    /*
+     * Calculates the pagerank of the graph in a snapshot file as worker
+     * get_worker() of get_num_processes() processes started on their
+     * own, which meet at the address given to set_worker() and read
+     * only their own rows. The first worker is left with the pagerank.
+     */
+    int worker_pagerank(const string &filename);
+
+    /*
+     * Returns whether the graph is streamed from a snapshot opened with
+     * open_snapshot().
+     */
+    const bool get_streamed();
+
+    /*
+     * Returns the number of arcs sorted in memory at a time by
+     * build_snapshot().
+     */
+    const size_t get_run_arcs();
+
+    /*
+     * Sets the number of arcs sorted in memory at a time by
+     * build_snapshot(); each takes 16 bytes.
+     */
+    void set_run_arcs(size_t n);
+
+    /*
+     * Reads a pagerank vector, as output by print_pagerank_v() or
+     * print_pagerank_b(), for the next call to pagerank() to start from
+     * instead of its default initial vector; the graph must have been
+     * read already. Binary files are recognised by their first record.
+     * Lines of text files are matched to vertices by name, or by index
+     * for numeric input; binary records are always matched by index.
+     * Vertices that are not found in the file start with the uniform
+     * value 1 / n, and lines or records that do not match any vertex
+     * are ignored. The starting vector is normalised by pagerank().
+     *
+     * Returns the number of vertices that were found in the file.
+     */
+    size_t read_pagerank(const string &filename);
+
+    /*
+     * Builds the hyperlink matrix from the buffered arcs: a counting sort
+     * on the destination vertex packs the arcs into contiguous compressed
+     * sparse row (CSR) arrays, then each row is sorted and duplicate arcs
+     * are removed. The number of outgoing links of each vertex is counted
+     * over the unique arcs, and its reciprocal is precomputed. Column
+     * indices take 32 bits when the number of vertices allows it, and 64
+     * bits otherwise. It is called by read_file(string&), and by
+     * pagerank() if needed; after that the arc buffer is released.
+     */
+    void finalize();
+
+    /*
+     * Returns why the current settings cannot be combined, or an empty
+     * string if they can; pagerank() and worker_pagerank() stop with
+     * this error before calculating anything.
+     */
+    const string check_settings();
+
     /*
      * Calculates the pagerank of the hyperlink matrix.
      */
     void pagerank();
 
+    /*
+     * Calculates the pagerank like pagerank(), but returns why it
+     * failed instead of stopping with an error, or an empty string.
+     */
+    const string try_pagerank();
+
+    /*
+     * Renumbers the vertices of the graph as selected by o, so that
+     * vertices whose arcs are read together in an iteration are close
+     * to each other in the pagerank vector and more of its accesses hit
+     * the cache. Vertex indices normally follow the order in which the
+     * vertices first appear in the input, or the numbers of the input,
+     * which scatters the neighbours of a vertex over the whole vector.
+     *
+     * ORDERING_DEGREE puts the vertices with the most outgoing links,
+     * whose pagerank is read by the most rows, first. ORDERING_RCM
+     * numbers the vertices in the reverse of the breadth first order
+     * of Cuthill and McKee, with arcs taken in both directions, which
+     * keeps the neighbours of each vertex close to it. ORDERING_GORDER
+     * places the vertices one at a time, each time picking the vertex
+     * with the most arcs to, and incoming neighbours shared with, the
+     * last few placed (Wei et al.); shared neighbours with more than 64
+     * outgoing links are not counted, to keep it fast on skewed graphs.
+     * The last two take the memory of the outgoing arcs while ordering.
+     *
+     * The rows and the number of outgoing links of each vertex are
+     * permuted together, and the vertex names are kept as they are:
+     * pagerank() and monte_carlo_pagerank() map their results back to
+     * the original indices, so the output does not change, besides the
+     * rounding of the sums. The other calculations, snapshots and
+     * updates are not available on a reordered graph, nor on a
+     * streamed one.
+     */
+    void reorder(Ordering o);
+
+    /*
+     * Reorders the graph by the name of the ordering, as listed in
+     * ORDERING_NAMES. Returns false if there is no such ordering.
+     */
+    bool reorder(const string &name);
+
+    /*
+     * Returns true if the graph has been reordered.
+     */
+    const bool get_reordered();
+
+    /*
+     * Adds the insertion of an arc from vertex from to vertex to, given
+     * by name or, for numeric input, by index, to the changes applied
+     * by the next update_pagerank(). Vertices that are not in the graph
+     * are added to it.
+     */
+    void insert_arc(string_view from, string_view to);
+
+    /*
+     * Adds the deletion of the arc from vertex from to vertex to, given
+     * as in insert_arc(string_view, string_view), to the changes applied
+     * by the next update_pagerank(). Deleting an arc that is not in the
+     * graph changes nothing; vertices are never removed.
+     */
+    void delete_arc(string_view from, string_view to);
+
+    /*
+     * Reads a batch of changes from in, adding them as with
+     * insert_arc(string_view, string_view) and
+     * delete_arc(string_view, string_view). Each line holds a change,
+     * as a + for an insertion or a - for a deletion followed by an arc
+     * in the format of the graph file; lines in any other format are
+     * ignored. The batch ends at an empty line or at the end of in.
+     *
+     * Returns false if the end of in was reached without reading a
+     * batch.
+     */
+    bool read_delta(istream &in);
+
+    /*
+     * Applies the changes added since the last call to the graph and
+     * updates the pagerank vector for them by pushing residuals locally
+     * instead of recalculating it, calculating it first if needed; see
+     * get_error_bound().
+     */
+    void update_pagerank();
+
+    /*
+     * Adds vertex, given by name or, for numeric input, by index, to the
+     * seed set named set, creating the set if needed; the graph must have
+     * been read already. Vertices that are not in the graph are ignored.
+     */
+    void add_seed(string_view set, string_view vertex);
+
+    /*
+     * Reads seed sets from filename; each line holds the name of a set
+     * and a vertex of it, separated by the delimiter of the graph file,
+     * and is added with add_seed(string_view, string_view).
+     *
+     * Returns the number of seed sets.
+     */
+    size_t read_seeds(const string &filename);
+
+    /*
+     * Returns the number of seed sets.
+     */
+    const size_t get_num_seed_sets();
+
+    /*
+     * Returns the name of seed set s.
+     */
+    const string &get_seed_set_name(size_t s);
+
+    /*
+     * Calculates the personalized pagerank of every seed set with
+     * vertices in the graph: teleportation, and the mass of dangling
+     * vertices, go uniformly to the vertices of the set instead of all
+     * vertices, so a set holding every vertex gives the pagerank. As
+     * each set converges, its pagerank vector becomes the one returned
+     * by get_pagerank(), its iterations the ones returned by
+     * get_num_iterations(), and done(s) is called with its index s;
+     * sets are not done in any particular order.
+     *
+     * The sets are iterated together, SEED_BLOCK at a time, so that each
+     * row of the hyperlink matrix is read once per iteration for all of
+     * them. Their pagerank vectors are interleaved, with the values of
+     * each vertex in consecutive elements, and the additions of a row
+     * are carried out on all of them at once, which the compiler can
+     * vectorize. When a set converges, its place is taken by the next
+     * one, so every set stops on its own.
+     */
+    void personalized_pagerank(const function<void(size_t)> &done);
+
+    /*
+     * Estimates the pagerank vector by running the given number of
+     * random walks from every vertex, instead of iterating: at each
+     * step a walk stops with probability 1 - alpha, and otherwise
+     * follows one of the outgoing arcs of its vertex, chosen uniformly,
+     * or moves to any vertex, chosen uniformly, from a dangling one.
+     * The pagerank of a vertex is estimated by the share of all the
+     * steps of all the walks that visited it, and its error shrinks
+     * with the square root of the walks; the vertices with the highest
+     * pagerank are estimated well even by a few walks.
+     *
+     * The vertices are divided into blocks, which the threads take in
+     * turn, and the walks of each block draw from their own random
+     * number generator, seeded by the block, so that the results do not
+     * depend on the number of threads. Each thread counts its visits in
+     * its own vector, and the vectors are added at the end; this takes
+     * a vector of 64 bit counters per thread.
+     */
+    void monte_carlo_pagerank(unsigned long walks = DEFAULT_WALKS);
+
+    /*
+     * Returns the number of steps of the random walks performed by the
+     * last call to monte_carlo_pagerank().
+     */
+    const unsigned long get_num_steps();
+
+    /*
+     * Approximates the personalized pagerank of the vertices in seeds,
+     * as personalized_pagerank() defines it, by pushing mass forward
+     * from them along the outgoing arcs (Andersen, Chung and Lang): the
+     * seeds start with all of it as residual, and a vertex whose
+     * residual exceeds epsilon times its outdegree keeps 1 - alpha of
+     * it as rank and pushes the rest evenly to the vertices it links
+     * to. Dangling vertices push theirs back to the seeds. Only the
+     * vertices near the seeds are touched, so a query takes time that
+     * depends on epsilon and not on the size of the graph, once the
+     * outgoing arcs have been built by the first one.
+     *
+     * Fills top with the k vertices with the highest rank, or all the
+     * vertices reached if k is 0, as (index, rank) pairs, highest
+     * first; vertices not reached have rank 0. Returns the mass left
+     * unpushed, which bounds the L1 error of the ranks. Seeds that are
+     * not vertices of the graph are ignored.
+     */
+    double local_pagerank(const vector<size_t> &seeds, double epsilon,
+                          size_t k, vector< pair<size_t, double> > &top);
+
+    /*
+     * The same, for the single vertex named seed.
+     */
+    double local_pagerank(string_view seed, double epsilon, size_t k,
+                          vector< pair<size_t, double> > &top);
+
+    /*
+     * Outputs the vertices of top, as filled by local_pagerank(), in
+     * the format of print_pagerank_v().
+     */
+    const void print_pagerank_list(
+        const vector< pair<size_t, double> > &top);
+
+    /*
+     * Returns the number of pushes performed by the last call to
+     * update_pagerank() or local_pagerank().
+     */
+    const unsigned long get_num_pushes();
+
+    /*
+     * Returns the bound of the L1 error of the pagerank vector after
+     * the last call to update_pagerank(), as described there.
+     */
+    const double get_error_bound();
+
+    /*
+     * Returns the number of iterations performed by the last call to
+     * pagerank().
+     */
+    const unsigned long get_num_iterations();
+
+    /*
+     * Returns, for each extrapolation applied by the last call to
+     * pagerank(), the iteration after which it was applied and an
+     * estimate of the power iterations it saved. The estimate is based
+     * on the rate of convergence just before the extrapolation, and is
+     * negative if the extrapolation slowed convergence down.
+     */
+    const vector< pair<unsigned long, double> > &get_extrapolation_savings();
+
     /*
      * Returns the pagerank vector of the hyperlink matrix.
      */
@@ -151,7 +917,10 @@ public:
      */
     const string get_node_name(size_t index);
 
-    const map<size_t, string>& get_mapping();
+    /*
+     * Returns the mapping between string node IDs and numeric ones.
+     */
+    const Dictionary& get_mapping();
     
     /*
      * Returns the pagerank damping factor.
@@ -187,6 +956,199 @@ public:
      */
     void set_convergence(double c);
 
+    /*
+     * Returns the number of threads used for the calculations.
+     */
+    const unsigned int get_num_threads();
+
+    /*
+     * Sets the number of threads used for the calculations. The results
+     * do not depend on the number of threads.
+     */
+    void set_num_threads(unsigned int n);
+
+    /*
+     * Returns the number of worker processes of the power method.
+     */
+    const unsigned int get_num_processes();
+
+    /*
+     * Sets the number of processes among which the power method splits
+     * the rows of the hyperlink matrix; pagerank() forks them on this
+     * host, and worker_pagerank() joins ones started on their own.
+     */
+    void set_num_processes(unsigned int n);
+
+    /*
+     * Returns the index of this process among the workers started on
+     * their own, as set by set_worker().
+     */
+    const unsigned int get_worker();
+
+    /*
+     * Makes this process worker w, counting from 0, of the
+     * get_num_processes() workers of worker_pagerank(), which meet at
+     * address: host:port, for TCP, or the path of a Unix domain socket.
+     * The first worker listens on it.
+     */
+    void set_worker(unsigned int w, const string &address);
+
+    /*
+     * Returns true if the pagerank calculations are carried out in single
+     * precision (float) instead of double precision.
+     */
+    const bool get_single_precision();
+
+    /*
+     * Specifies whether the pagerank calculations are carried out in
+     * single precision (float), halving the memory used by the rank
+     * vectors, or in double precision. The results are returned in
+     * double precision in either case.
+     */
+    void set_single_precision(bool s);
+
+    /*
+     * Returns true if the packed rows use 64 bit vertex indices.
+     */
+    const bool get_wide_indices();
+
+    /*
+     * Forces the use of 64 bit vertex indices in the packed rows, even if
+     * the graph is small enough for 32 bit ones. It must be called
+     * before read_file(string&).
+     */
+    void set_force_wide_indices(bool w);
+
+    /*
+     * Returns the iterative method used to calculate the pagerank.
+     */
+    const Solver get_solver();
+
+    /*
+     * Returns the name of the iterative method used to calculate the
+     * pagerank, as listed in SOLVER_NAMES.
+     */
+    const char *get_solver_name();
+
+    /*
+     * Sets the iterative method used to calculate the pagerank.
+     */
+    void set_solver(Solver s);
+
+    /*
+     * Sets the iterative method used to calculate the pagerank by its
+     * name, as listed in SOLVER_NAMES. Returns false if there is no
+     * such method.
+     */
+    bool set_solver(const string &name);
+
+    /*
+     * Returns the extrapolation method used to accelerate the power
+     * method.
+     */
+    const Extrapolation get_extrapolation();
+
+    /*
+     * Returns the name of the extrapolation method used to accelerate
+     * the power method, as listed in EXTRAPOLATION_NAMES.
+     */
+    const char *get_extrapolation_name();
+
+    /*
+     * Sets the extrapolation method used to accelerate the power
+     * method; pagerank() stops with an error if it is combined with
+     * the Gauss-Seidel solver or with fewer power iterations between
+     * extrapolations than MIN_EXTRAPOLATION_PERIODS gives for it.
+     */
+    void set_extrapolation(Extrapolation e);
+
+    /*
+     * Sets the extrapolation method used to accelerate the power method
+     * by its name, as listed in EXTRAPOLATION_NAMES. Returns false if
+     * there is no such method.
+     */
+    bool set_extrapolation(const string &name);
+
+    /*
+     * Returns the destinations per bin of the propagation blocking
+     * kernel, or 0 if the row kernel is used.
+     */
+    const size_t get_bin_width();
+
+    /*
+     * Sets the destinations per bin of the propagation blocking kernel
+     * of the power method, rounded up to a power of two that is a
+     * multiple of the rows of a block, or selects the row kernel with 0.
+     * The row kernel reads the pagerank of the sources of the arcs of
+     * each row, which is a random access into a vector that may be much
+     * larger than the cache; the propagation blocking kernel writes the
+     * shares of the sources sequentially into the bins, and adds them
+     * up bin by bin, so that its random accesses stay within a bin.
+     * Bins whose pagerank vector fits in the L2 cache, e.g., 32768
+     * vertices for 256 KB, pay off on graphs much larger than the
+     * last level cache; the kernel takes memory for the outgoing arcs
+     * and for one destination and one value per arc.
+     */
+    void set_bin_width(size_t w);
+
+    /*
+     * Returns true if the power method skips the vertices without
+     * incoming or without outgoing links.
+     */
+    const bool get_skip_trivial();
+
+    /*
+     * Specifies whether the power method iterates only over the
+     * vertices with both incoming and outgoing links, accounting for
+     * the others from precomputed sums.
+     */
+    void set_skip_trivial(bool s);
+
+    /*
+     * Returns the number of vertices without incoming links found by the
+     * last pagerank() that skipped trivial vertices.
+     */
+    const size_t get_num_unreferenced();
+
+    /*
+     * Returns the number of dangling vertices found by the last
+     * pagerank() that skipped trivial vertices.
+     */
+    const size_t get_num_dangling();
+
+    /*
+     * Returns the relative change below which the adaptive power method
+     * freezes a vertex, or 0 if it is not used.
+     */
+    const double get_adaptive_tolerance();
+
+    /*
+     * Selects the adaptive power method, which stops iterating over
+     * each vertex once its pagerank has converged to the given relative
+     * tolerance, or the plain power method with 0; see
+     * get_active_sizes().
+     */
+    void set_adaptive_tolerance(double t);
+
+    /*
+     * Returns the number of active vertices in each iteration of the
+     * last pagerank() with the adaptive power method.
+     */
+    const vector<size_t> &get_active_sizes();
+
+    /*
+     * Returns the number of power iterations between extrapolations.
+     */
+    const unsigned long get_extrapolation_period();
+
+    /*
+     * Sets the number of power iterations between extrapolations; it
+     * must be at least MIN_EXTRAPOLATION_PERIODS for the extrapolation
+     * method, which needs that many successive iterates besides the
+     * current one, or pagerank() stops with an error.
+     */
+    void set_extrapolation_period(unsigned long p);
+
     /*
      * Returns true when tracing output is enabled, false otherwise.
      */
@@ -233,6 +1195,10 @@ public:
      * - whether numeric or string input is expected (numeric)
      * - the delimiter for separating the two vertices in each line of the
      *   input file (delim)
+     * - the number of threads used for the calculations (threads)
+     * - whether the calculations are in single precision (float)
+     * - the iterative method used (solver)
+     * - the extrapolation method and period (extrapolation)
      */
     const void print_params(ostream &out);
 
@@ -260,6 +1226,33 @@ public:
      * Outputs the pageranks vector in a more verbose way than print_pagerank():
      * it substitutes string vertex names for numeric IDs, if available,
      * and also outputs the index number of each vector, starting from zero.
+     * The values are output in the shortest form that reads back to the
+     * same double. The output is formatted in large blocks, in parallel
+     * if more than one thread is used, and the sum of the values is
+     * output to cerr.
      */
     const void print_pagerank_v();
+
+    /*
+     * Outputs the pagerank vector to cout in binary form, as a series of
+     * PagerankRecord structures, one for each vertex in index order. The
+     * sum of the values is output to cerr.
+     */
+    const void print_pagerank_b();
+
+    /*
+     * Returns in top the indices of the k vertices with the highest
+     * pagerank, highest first; vertices with equal pagerank are ordered
+     * by index. The vertices are selected with bounded heaps, one for
+     * each thread, without sorting the whole vector.
+     */
+    void top_pagerank(size_t k, vector<size_t> &top);
+
+    /*
+     * Outputs the k vertices with the highest pagerank, highest first,
+     * in the format of print_pagerank_v().
+     */
+    const void print_pagerank_top(size_t k);
 };
+
+#endif
@@ -0,0 +1,258 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <math.h>
+
+#include "update.h"
+#include "parallel.h"
+
+IncrementalPagerank::IncrementalPagerank()
+    : base(0),
+      num_pushes(0),
+      error_bound(0) {
+}
+
+bool IncrementalPagerank::started(size_t num_rows) const {
+    return num_rows > 0 && inc_pr.size() == num_rows;
+}
+
+void IncrementalPagerank::clear() {
+    inc_pr.clear();
+    residual.clear();
+    changed.clear();
+}
+
+template <class Index>
+void IncrementalPagerank::start(const Csr<Index> &in_rows,
+                                const vector<double> &pr, double alpha,
+                                unsigned int num_threads) {
+
+    size_t num_rows = in_rows.num_rows();
+
+    /*
+     * The pagerank vector solves the system with the constant term that
+     * its dangling mass and teleportation give each vertex.
+     */
+    double sum_pr = 0;
+    double dangling_pr = 0;
+    for (size_t k = 0; k < num_rows; k++) {
+        sum_pr += pr[k];
+        if (in_rows.dangling(k)) {
+            dangling_pr += pr[k];
+        }
+    }
+    base = (num_rows > 0)
+        ? (alpha * dangling_pr + (1 - alpha) * sum_pr) / num_rows
+        : 1;
+    inc_pr.assign(pr.begin(), pr.end());
+    residual.resize(num_rows);
+    changed.clear();
+
+    const vector<size_t> &offsets = in_rows.offsets;
+    const vector<Index> &cols = in_rows.cols;
+    const vector<double> &inv_outgoing = in_rows.inv_outgoing;
+    vector<size_t> bounds;
+    partition_rows(offsets, bounds, num_threads);
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = min(bounds[t] * BLOCK_ROWS, num_rows);
+        size_t last = min(bounds[t + 1] * BLOCK_ROWS, num_rows);
+        for (size_t i = first; i < last; i++) {
+            double h = 0.0;
+            for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                h += inc_pr[cols[k]] * inv_outgoing[cols[k]];
+            }
+            residual[i] = base - inc_pr[i] + alpha * h;
+        }
+    });
+}
+
+void IncrementalPagerank::add_vertices(size_t num_rows) {
+    for (size_t k = inc_pr.size(); k < num_rows; k++) {
+        changed.push_back(k);
+    }
+    inc_pr.resize(num_rows, 0);
+    residual.resize(num_rows, base);
+}
+
+template <class Index>
+void IncrementalPagerank::move_shares(const Csr<Index> &out_rows,
+                                      const vector<DeltaArc> &delta,
+                                      double alpha, double sign) {
+
+    /*
+     * The residual of the vertices linked from a changed source loses
+     * its share of the source's rank over the old arcs, and gains it
+     * over the new ones.
+     */
+    for (size_t k = 0; k < delta.size(); k++) {
+        size_t u = delta[k].from;
+        if (k > 0 && delta[k - 1].from == u) {
+            continue;
+        }
+        size_t first = out_rows.offsets[u];
+        size_t last = out_rows.offsets[u + 1];
+        if (first == last) {
+            continue;
+        }
+        double share = sign * alpha * inc_pr[u] / (last - first);
+        for (size_t a = first; a < last; a++) {
+            residual[out_rows.cols[a]] += share;
+            changed.push_back(out_rows.cols[a]);
+        }
+    }
+}
+
+template <class Index>
+void IncrementalPagerank::push(const Csr<Index> &out_rows, double alpha,
+                               double convergence, vector<double> &pr) {
+
+    size_t num_rows = inc_pr.size();
+    const vector<size_t> &out_row_offsets = out_rows.offsets;
+    const vector<Index> &out_cols = out_rows.cols;
+
+    /*
+     * Push the vertices whose residual exceeds an equal share of the
+     * target, starting from the changed ones, until the target is met.
+     * If they run out first, the residual left elsewhere is above the
+     * target, so the rest of the vertices are checked as well; once
+     * they run out again, no residual exceeds its share.
+     */
+    double sum_inc = 0;
+    double sum_residual = 0;
+    for (size_t k = 0; k < num_rows; k++) {
+        sum_inc += inc_pr[k];
+        sum_residual += fabs(residual[k]);
+    }
+    double threshold = (num_rows > 0)
+        ? convergence * sum_inc / num_rows
+        : 0;
+    vector<char> queued(num_rows, 0);
+    deque<size_t> work;
+    auto enqueue = [&](size_t v) {
+        if (!queued[v] && fabs(residual[v]) > threshold) {
+            queued[v] = 1;
+            work.push_back(v);
+        }
+    };
+    for (size_t k = 0; k < changed.size(); k++) {
+        enqueue(changed[k]);
+    }
+    vector<size_t>().swap(changed);
+
+    num_pushes = 0;
+    bool checked_all = false;
+    while (sum_residual > convergence * sum_inc) {
+        if (work.empty()) {
+            if (checked_all) {
+                break;
+            }
+            checked_all = true;
+            for (size_t k = 0; k < num_rows; k++) {
+                enqueue(k);
+            }
+            if (work.empty()) {
+                break;
+            }
+        }
+        size_t u = work.front();
+        work.pop_front();
+        queued[u] = 0;
+        double r = residual[u];
+        if (fabs(r) <= threshold) {
+            continue;
+        }
+        inc_pr[u] += r;
+        sum_inc += r;
+        residual[u] = 0;
+        sum_residual -= fabs(r);
+        num_pushes++;
+        size_t first = out_row_offsets[u];
+        size_t last = out_row_offsets[u + 1];
+        if (first == last) {
+            continue;
+        }
+        double share = alpha * r / (last - first);
+        for (size_t a = first; a < last; a++) {
+            size_t v = out_cols[a];
+            double old_residual = residual[v];
+            residual[v] += share;
+            sum_residual += fabs(residual[v]) - fabs(old_residual);
+            enqueue(v);
+        }
+    }
+
+    /* The bound and the pagerank vector, from exact sums */
+    sum_inc = 0;
+    sum_residual = 0;
+    for (size_t k = 0; k < num_rows; k++) {
+        sum_inc += inc_pr[k];
+        sum_residual += fabs(residual[k]);
+    }
+    double e = sum_residual / (1 - alpha);
+    error_bound = (sum_inc > e)
+        ? 2 * e / (sum_inc - e)
+        : numeric_limits<double>::infinity();
+    pr.resize(num_rows);
+    for (size_t k = 0; k < num_rows; k++) {
+        pr[k] = inc_pr[k] / sum_inc;
+    }
+}
+
+unsigned long IncrementalPagerank::get_num_pushes() const {
+    return num_pushes;
+}
+
+double IncrementalPagerank::get_error_bound() const {
+    return error_bound;
+}
+
+template void IncrementalPagerank::start(const Csr<uint32_t> &,
+                                         const vector<double> &, double,
+                                         unsigned int);
+template void IncrementalPagerank::start(const Csr<uint64_t> &,
+                                         const vector<double> &, double,
+                                         unsigned int);
+template void IncrementalPagerank::move_shares(const Csr<uint32_t> &,
+                                               const vector<DeltaArc> &,
+                                               double, double);
+template void IncrementalPagerank::move_shares(const Csr<uint64_t> &,
+                                               const vector<DeltaArc> &,
+                                               double, double);
+template void IncrementalPagerank::push(const Csr<uint32_t> &, double,
+                                        double, vector<double> &);
+template void IncrementalPagerank::push(const Csr<uint64_t> &, double,
+                                        double, vector<double> &);
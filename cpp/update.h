@@ -0,0 +1,136 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef UPDATE_H
+#define UPDATE_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "csr.h"
+
+using namespace std;
+
+/*
+ * An arc inserted into or deleted from the graph by a batch of changes,
+ * as given to Table::update_pagerank().
+ */
+struct DeltaArc {
+    size_t from; // the source vertex
+    size_t to; // the destination vertex
+    bool insert; // inserted if true, deleted if false
+};
+
+/*
+ * The state that Table::update_pagerank() keeps between batches of
+ * changes: an unnormalised pagerank vector y and its residual r, for
+ * the system described there, which the changes disturb and pushes
+ * bring back within the convergence criterion. The graph itself is
+ * owned and changed by the table; the pushes only read its outgoing
+ * rows.
+ */
+class IncrementalPagerank {
+private:
+
+    vector<double> inc_pr; // unnormalised pagerank vector
+    vector<double> residual; // residual of inc_pr
+    double base; // constant term of the system, for every vertex
+    vector<size_t> changed; // vertices whose residual has changed since
+                            // the last push()
+    unsigned long num_pushes; // pushes by the last push()
+    double error_bound; // bound of the error after the last push()
+
+public:
+
+    IncrementalPagerank();
+
+    /*
+     * Returns true if the state has been started, with start(), for a
+     * graph of num_rows vertices.
+     */
+    bool started(size_t num_rows) const;
+
+    /*
+     * Drops the state, so that the next batch starts over.
+     */
+    void clear();
+
+    /*
+     * Starts the state from the pagerank vector pr of the graph whose
+     * incoming links are in_rows, calculating the residual on the given
+     * number of threads.
+     */
+    template <class Index>
+    void start(const Csr<Index> &in_rows, const vector<double> &pr,
+               double alpha, unsigned int num_threads);
+
+    /*
+     * Adds vertices up to num_rows, with no rank and the constant term
+     * as their residual.
+     */
+    void add_vertices(size_t num_rows);
+
+    /*
+     * Moves the shares of the sources of the changes in delta, sorted by
+     * source, over their outgoing links in out_rows: out of the
+     * residuals of the vertices they link to with sign -1, before the
+     * rows are changed, and into them with sign 1, afterwards.
+     */
+    template <class Index>
+    void move_shares(const Csr<Index> &out_rows, const vector<DeltaArc> &delta,
+                     double alpha, double sign);
+
+    /*
+     * Pushes residuals along the outgoing links in out_rows, starting
+     * from the vertices whose residual has changed, until their L1 norm
+     * is at most convergence times the sum of y, and leaves the
+     * normalisation of y in pr.
+     */
+    template <class Index>
+    void push(const Csr<Index> &out_rows, double alpha, double convergence,
+              vector<double> &pr);
+
+    /*
+     * Returns the number of pushes performed by the last push().
+     */
+    unsigned long get_num_pushes() const;
+
+    /*
+     * Returns the bound of the L1 error of the pagerank vector left by
+     * the last push().
+     */
+    double get_error_bound() const;
+};
+
+#endif
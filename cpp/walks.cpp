@@ -0,0 +1,130 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include "walks.h"
+#include "parallel.h"
+
+/*
+ * Seed of the random number generators of random_walks(); the
+ * generator of each block of vertices is seeded by this plus the index
+ * of the block.
+ */
+const uint64_t WALK_SEED = 0x5eed;
+
+template <class Index>
+unsigned long random_walks(const Csr<Index> &out_rows, unsigned long walks,
+                           double alpha, unsigned int num_threads,
+                           vector<double> &pr) {
+
+    size_t num_rows = out_rows.num_rows();
+    const vector<size_t> &out_row_offsets = out_rows.offsets;
+    const vector<Index> &out_cols = out_rows.cols;
+    size_t num_blocks = (num_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+    vector< vector<uint64_t> > visits(num_threads);
+    vector<unsigned long> steps(num_threads, 0);
+    atomic<size_t> next_block(0);
+    run_parallel(num_threads, [&](unsigned int t) {
+        vector<uint64_t> &count = visits[t];
+        count.assign(num_rows, 0);
+        unsigned long s = 0;
+        /* A uniform number in [0, 1) */
+        auto uniform = [](mt19937_64 &rng) {
+            return (rng() >> 11) * (1.0 / (UINT64_C(1) << 53));
+        };
+        for (size_t b = next_block++; b < num_blocks; b = next_block++) {
+            mt19937_64 rng(WALK_SEED + b);
+            size_t first = b * BLOCK_ROWS;
+            size_t last = min(first + BLOCK_ROWS, num_rows);
+            for (size_t i = first; i < last; i++) {
+                for (unsigned long w = 0; w < walks; w++) {
+                    size_t v = i;
+                    while (true) {
+                        count[v]++;
+                        s++;
+                        /*
+                         * A walk that goes on has a number uniform in
+                         * [0, alpha), which also picks the next vertex.
+                         */
+                        double u = uniform(rng);
+                        if (u >= alpha) {
+                            break;
+                        }
+                        u /= alpha;
+                        size_t a = out_row_offsets[v];
+                        size_t degree = out_row_offsets[v + 1] - a;
+                        if (degree == 0) {
+                            v = min((size_t) (u * num_rows), num_rows - 1);
+                        } else {
+                            v = out_cols[a + min((size_t) (u * degree),
+                                                 degree - 1)];
+                        }
+                    }
+                }
+            }
+        }
+        steps[t] = s;
+    });
+
+    unsigned long num_steps = 0;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        num_steps += steps[t];
+    }
+
+    /* Each thread adds up the counts of its part of the vertices */
+    pr.resize(num_rows);
+    run_parallel(num_threads, [&](unsigned int t) {
+        size_t first = num_rows / num_threads * t
+            + num_rows % num_threads * t / num_threads;
+        size_t last = num_rows / num_threads * (t + 1)
+            + num_rows % num_threads * (t + 1) / num_threads;
+        for (size_t i = first; i < last; i++) {
+            uint64_t c = 0;
+            for (unsigned int u = 0; u < num_threads; u++) {
+                c += visits[u][i];
+            }
+            pr[i] = (double) c / num_steps;
+        }
+    });
+    return num_steps;
+}
+
+template unsigned long random_walks(const Csr<uint32_t> &, unsigned long,
+                                    double, unsigned int, vector<double> &);
+template unsigned long random_walks(const Csr<uint64_t> &, unsigned long,
+                                    double, unsigned int, vector<double> &);
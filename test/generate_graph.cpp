@@ -0,0 +1,148 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+ 
+   All rights reserved.
+  
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ 
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ 
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+ 
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <iostream>
+#include <random>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+
+using namespace std;
+
+/*
+ * Generates a synthetic graph with a skewed degree distribution, for
+ * benchmarks on graphs larger than the test graphs, in the numeric
+ * format read by pagerank -n -d " ". Each arc is placed by the R-MAT
+ * model: its source and destination are chosen one bit at a time, by
+ * picking a quadrant of the adjacency matrix with probabilities A, B,
+ * C and 1 - A - B - C. The vertex indices are then scattered by an
+ * invertible hash, so that the high degree vertices are not clustered
+ * at the start, and indices beyond the number of vertices are drawn
+ * again.
+ */
+
+const double A = 0.57;
+const double B = 0.19;
+const double C = 0.19;
+
+void usage() {
+    cerr << "Usage: generate_graph [-s seed] <vertices> <arcs>" << endl;
+}
+
+/*
+ * An invertible mapping of the indices below 1 << bits onto themselves.
+ */
+uint64_t scatter(uint64_t v, unsigned int bits) {
+    uint64_t mask = (bits < 64) ? ((uint64_t) 1 << bits) - 1 : ~(uint64_t) 0;
+    v = (v ^ 0x5851f42d4c957f2dULL) & mask;
+    for (int round = 0; round < 2; round++) {
+        v = (v * 0x9e3779b97f4a7c15ULL) & mask;
+        v ^= v >> (bits / 2 + 1);
+    }
+    return v;
+}
+
+int main(int argc, char *argv[]) {
+
+    uint64_t seed = 1;
+    int i = 1;
+    if (argc > 2 && !strcmp(argv[1], "-s")) {
+        seed = strtoull(argv[2], NULL, 10);
+        i = 3;
+    }
+    if (argc - i != 2) {
+        usage();
+        exit(1);
+    }
+    uint64_t num_vertices = strtoull(argv[i], NULL, 10);
+    uint64_t num_arcs = strtoull(argv[i + 1], NULL, 10);
+    if (num_vertices == 0) {
+        usage();
+        exit(1);
+    }
+
+    unsigned int bits = 0;
+    while (((uint64_t) 1 << bits) < num_vertices) {
+        bits++;
+    }
+
+    /*
+     * The quadrants are picked with 16 bit random numbers, four from
+     * each draw of the generator.
+     */
+    mt19937_64 rng(seed);
+    const uint32_t AB = (uint32_t) ((A + B) * 65536);
+    const uint32_t A_ = (uint32_t) (A * 65536);
+    const uint32_t ABC = (uint32_t) ((A + B + C) * 65536);
+    uint64_t random_bits = 0;
+    unsigned int random_left = 0;
+    auto vertex_pair = [&](uint64_t &from, uint64_t &to) {
+        do {
+            from = 0;
+            to = 0;
+            for (unsigned int b = 0; b < bits; b++) {
+                if (random_left == 0) {
+                    random_bits = rng();
+                    random_left = 4;
+                }
+                uint32_t r = random_bits & 0xffff;
+                random_bits >>= 16;
+                random_left--;
+                from = (from << 1) | (r >= AB);
+                to = (to << 1) | ((r >= A_ && r < AB) || r >= ABC);
+            }
+            from = scatter(from, bits);
+            to = scatter(to, bits);
+        } while (from >= num_vertices || to >= num_vertices);
+    };
+
+    string out;
+    char num[24];
+    for (uint64_t k = 0; k < num_arcs; k++) {
+        uint64_t from, to;
+        vertex_pair(from, to);
+        out.append(num, to_chars(num, num + sizeof(num), from).ptr - num);
+        out.push_back(' ');
+        out.append(num, to_chars(num, num + sizeof(num), to).ptr - num);
+        out.push_back('\n');
+        if (out.size() > (1 << 20)) {
+            cout.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+    cout.write(out.data(), out.size());
+
+    return 0;
+}
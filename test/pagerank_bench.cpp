@@ -0,0 +1,273 @@
+/* Copyright (c) 2010-2011, Panos Louridas, GRNET S.A.
+ 
+   All rights reserved.
+  
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ 
+   * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ 
+   * Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the
+   distribution.
+ 
+   * Neither the name of GRNET S.A, nor the names of its contributors
+   may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+   FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+   COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+   INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+   HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+   STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+   ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+   OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "table.h"
+
+using namespace std;
+
+/*
+ * Times the phases of a pagerank calculation, reading the graph, the
+ * power method and writing the results, separately on each graph given,
+ * and writes the timings as JSON to the standard output. Each graph is
+ * benchmarked in a process of its own, so that the peak memory reported
+ * is that of the graph alone.
+ */
+
+const unsigned int DEFAULT_RUNS = 5;
+const unsigned int DEFAULT_WARMUPS = 1;
+
+void usage() {
+    cerr << "Usage: pagerank_bench [-fw] [-r runs] [-k warmups] "
+         << "[-t threads] <graph>..." << endl
+         << " -f calculate in single precision" << endl
+         << " -w use 64 bit vertex indices" << endl
+         << " -r runs" << endl
+         << "    number of timed runs of each graph (default "
+         << DEFAULT_RUNS << ")" << endl
+         << " -k warmups" << endl
+         << "    number of runs of each graph before the timed ones "
+         << "(default " << DEFAULT_WARMUPS << ")" << endl
+         << " -t threads" << endl
+         << "    number of threads to use for the calculations" << endl
+         << "The graphs are read in numeric format, delimited by spaces."
+         << endl;
+}
+
+/*
+ * Writes s as a JSON string.
+ */
+void write_string(ostream &out, const string &s) {
+    out << '"';
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/*
+ * Writes the seconds taken by each run of a phase, their mean, sample
+ * standard deviation, minimum and maximum, and the arcs processed per
+ * second on average.
+ */
+void write_phase(ostream &out, const vector<double> &seconds,
+                 size_t num_arcs) {
+    double mean = 0, variance = 0;
+    double least = seconds[0], most = seconds[0];
+    for (size_t r = 0; r < seconds.size(); r++) {
+        mean += seconds[r];
+        least = min(least, seconds[r]);
+        most = max(most, seconds[r]);
+    }
+    mean /= seconds.size();
+    for (size_t r = 0; r < seconds.size(); r++) {
+        variance += (seconds[r] - mean) * (seconds[r] - mean);
+    }
+    if (seconds.size() > 1) {
+        variance /= seconds.size() - 1;
+    }
+
+    out << "\"seconds\": [";
+    for (size_t r = 0; r < seconds.size(); r++) {
+        out << (r > 0 ? ", " : "") << seconds[r];
+    }
+    out << "], \"mean\": " << mean
+        << ", \"stddev\": " << sqrt(variance)
+        << ", \"min\": " << least
+        << ", \"max\": " << most
+        << ", \"arcs_per_second\": " << (mean > 0 ? num_arcs / mean : 0);
+}
+
+/*
+ * Runs the phases of the calculation on graph warmups + runs times, and
+ * writes the timings of the last runs as a JSON object.
+ */
+void bench_graph(Table &t, const string &graph, unsigned int runs,
+                 unsigned int warmups, ostream &out) {
+
+    vector<double> read_seconds, pagerank_seconds, output_seconds;
+    unsigned long num_iterations = 0;
+
+    /* Progress and the results are discarded while timing */
+    ofstream null_stream("/dev/null");
+    streambuf *out_buf = cout.rdbuf(null_stream.rdbuf());
+    streambuf *err_buf = cerr.rdbuf(null_stream.rdbuf());
+
+    for (unsigned int r = 0; r < warmups + runs; r++) {
+        auto start = chrono::steady_clock::now();
+        t.read_file(graph);
+        auto read = chrono::steady_clock::now();
+        t.pagerank();
+        auto calculated = chrono::steady_clock::now();
+        t.print_pagerank_v();
+        auto written = chrono::steady_clock::now();
+        if (r < warmups) {
+            continue;
+        }
+        chrono::duration<double> elapsed = read - start;
+        read_seconds.push_back(elapsed.count());
+        elapsed = calculated - read;
+        pagerank_seconds.push_back(elapsed.count());
+        elapsed = written - calculated;
+        output_seconds.push_back(elapsed.count());
+        num_iterations = t.get_num_iterations();
+    }
+
+    cout.rdbuf(out_buf);
+    cerr.rdbuf(err_buf);
+
+    size_t num_arcs = t.get_num_arcs();
+    double mean_pagerank = 0;
+    for (size_t r = 0; r < pagerank_seconds.size(); r++) {
+        mean_pagerank += pagerank_seconds[r];
+    }
+    mean_pagerank /= pagerank_seconds.size();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    out << "    {\"graph\": ";
+    write_string(out, graph);
+    out << ", \"vertices\": " << t.get_num_rows()
+        << ", \"arcs\": " << num_arcs
+        << ", \"peak_rss_kb\": " << usage.ru_maxrss << "," << endl
+        << "     \"read\": {";
+    write_phase(out, read_seconds, num_arcs);
+    out << "}," << endl
+        << "     \"pagerank\": {";
+    write_phase(out, pagerank_seconds, num_arcs);
+    out << ", \"iterations\": " << num_iterations
+        << ", \"seconds_per_iteration\": "
+        << (num_iterations > 0 ? mean_pagerank / num_iterations : 0)
+        << "}," << endl
+        << "     \"output\": {";
+    write_phase(out, output_seconds, num_arcs);
+    out << "}}";
+}
+
+int main(int argc, char *argv[]) {
+
+    Table t;
+    unsigned int runs = DEFAULT_RUNS;
+    unsigned int warmups = DEFAULT_WARMUPS;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-f")) {
+            t.set_single_precision(true);
+        } else if (!strcmp(argv[i], "-w")) {
+            t.set_force_wide_indices(true);
+        } else if (!strcmp(argv[i], "-r") && i < argc - 1) {
+            runs = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-k") && i < argc - 1) {
+            warmups = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-t") && i < argc - 1) {
+            t.set_num_threads(strtol(argv[++i], NULL, 10));
+        } else {
+            usage();
+            exit(1);
+        }
+    }
+    if (i == argc || runs == 0) {
+        usage();
+        exit(1);
+    }
+
+    for (int g = i; g < argc; g++) {
+        if (access(argv[g], R_OK) != 0) {
+            cerr << "Cannot open file " << argv[g] << endl;
+            exit(1);
+        }
+    }
+
+    t.set_numeric(true);
+    t.set_delim(" ");
+    t.set_trace(false);
+
+    cout.precision(9);
+    cout << "{\"threads\": " << t.get_num_threads()
+         << ", \"float\": " << (t.get_single_precision() ? "true" : "false")
+         << ", \"runs\": " << runs
+         << ", \"warmups\": " << warmups
+         << "," << endl
+         << " \"graphs\": [" << endl;
+
+    for (int g = i; g < argc; g++) {
+        string graph = argv[g];
+        cout.flush();
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "Cannot fork" << endl;
+            exit(1);
+        }
+        if (pid == 0) {
+            if (g > i) {
+                cout << "," << endl;
+            }
+            bench_graph(t, graph, runs, warmups, cout);
+            cout.flush();
+            _exit(0);
+        }
+        int status;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0) {
+            cerr << "Benchmark of " << graph << " failed" << endl;
+            exit(1);
+        }
+    }
+
+    cout << endl << " ]}" << endl;
+}
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+function usage {
+    echo "pagerank_blocking.sh [-p threads] [-v vertices] [-a arcs] [width...]"
+    echo " -p number of threads for the calculations; default 1"
+    echo " -v vertices of the synthetic graph; default 50000000"
+    echo " -a arcs of the synthetic graph; default 4 times the vertices"
+    echo "Times the power method without propagation blocking and with"
+    echo "each bin width given (default 4096 32768 262144) on the"
+    echo "largest barabasi and erdos graphs and on a synthetic graph."
+    exit
+}
+
+threads=1
+vertices=50000000
+arcs=
+
+while getopts "p:v:a:h" opt
+do
+    case $opt in
+	p) threads=$OPTARG ;;
+	v) vertices=$OPTARG ;;
+	a) arcs=$OPTARG ;;
+	*) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ -z "$arcs" ]
+then
+    arcs=$((4 * vertices))
+fi
+widths="$@"
+if [ -z "$widths" ]
+then
+    widths="4096 32768 262144"
+fi
+
+pagerank=../cpp/pagerank
+synthetic="synthetic-${vertices}"
+TIMEFORMAT="%R"
+
+make -s -C ../cpp pagerank && make -s generate_graph || exit 1
+
+# Graphs are timed from snapshots, so that reading them takes little
+# of the time.
+for graph_name in barabasi-100000 erdos-100000 $synthetic
+do
+    snapshot="${graph_name}.snap"
+    if [ $graph_name == $synthetic ]
+    then
+	echo "generating" $graph_name "with" $arcs "arcs"
+	./generate_graph $vertices $arcs | \
+	    $pagerank -n -d " " -m 1 -w $snapshot > /dev/null 2>&1
+    else
+	$pagerank -n -d " " -m 1 -w $snapshot ${graph_name}.txt \
+	    > /dev/null 2>&1
+    fi
+    for width in 0 $widths
+    do
+	if [ $width -eq 0 ]
+	then
+	    options=""
+	else
+	    options="--bin-width $width"
+	fi
+	seconds=$( { time $pagerank -p $threads $options -r $snapshot \
+	    > /dev/null 2>&1 ; } 2>&1 )
+	echo $graph_name "bin width" $width ":" $seconds "s"
+    done
+    rm -f $snapshot
+done
@@ -39,15 +39,29 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <thread>
 
 #include <errno.h>
 #include <dirent.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include "table.h"
+#include "server.h"
 
 using namespace std;
 
 const double EPSILON = 0.000001;
+/*
+ * Random walk estimates of a pagerank p are checked to within this many
+ * times sqrt(p / (n * walks)), roughly the standard deviation of the
+ * estimate from walks random walks from each of the n vertices.
+ */
+const double WALK_DEVIATIONS = 3;
+const char *SNAPSHOT_FILENAME = "pagerank_test.snap";
+const char *SOCKET_FILENAME = "pagerank_test.sock";
 
 void error(const char *p,const char *p2) {
     cerr << p <<  ' ' << p2 <<  '\n';
@@ -59,10 +73,130 @@ void error(const string p,const string p2) {
     exit(1);
 }
 
+/*
+ * Sends request on the connection fd and returns the first line of the
+ * reply, keeping whatever follows it in pending.
+ */
+string request_line(int fd, const string &request, string &pending) {
+    const char *p = request.data();
+    const char *end = p + request.size();
+    while (p < end) {
+        ssize_t sent = send(fd, p, end - p, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            error("Cannot send request", request);
+        }
+        p += sent;
+    }
+    string::size_type eol;
+    while ((eol = pending.find('\n')) == string::npos) {
+        char buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            error("No reply to request", request);
+        }
+        pending.append(buf, n);
+    }
+    string line = pending.substr(0, eol);
+    pending.erase(0, eol + 1);
+    return line;
+}
+
+/*
+ * Serves the pagerank calculated by t and returns it as read back from
+ * the server, after having the server recalculate it.
+ */
+vector<double> served_pagerank(Table &t) {
+    Server server(t);
+    server.listen(SOCKET_FILENAME);
+    thread serving(&Server::run, &server);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, SOCKET_FILENAME);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *) &addr, sizeof(addr)) < 0) {
+        error("Cannot connect to socket", SOCKET_FILENAME);
+    }
+
+    string pending;
+    string reply = request_line(fd, "ALPHA " + to_string(t.get_alpha())
+                                + "\n", pending);
+    if (reply.compare(0, 3, "OK ")) {
+        error("Cannot recalculate:", reply);
+    }
+    vector<double> pr(t.get_num_rows());
+    for (size_t i = 0; i < pr.size(); i++) {
+        string name = t.get_node_name(i);
+        reply = request_line(fd, "RANK " + name + "\n", pending);
+        if (reply.compare(0, 3, "OK ")) {
+            error("Cannot read pagerank of " + name + ":", reply);
+        }
+        pr[i] = strtod(reply.c_str() + 3, NULL);
+    }
+    close(fd);
+
+    server.stop();
+    serving.join();
+    return pr;
+}
+
 void usage() {
-    cerr << "Usage: pagerank_test [-jp] <test_suite>" << endl
+    cerr << "Usage: pagerank_test [-jpfwsiuvlxkq] [-t threads] [-m solver] "
+         << "[-e extrapolation] [-r walks] [-b width] [-o ordering] "
+         << "[-a tolerance] [-n processes] [-g workers] <test_suite>"
+         << endl
          << " -j use Java test results" << endl
-         << " -p use Python test results (default)" << endl;
+         << " -p use Python test results (default)" << endl
+         << " -f calculate in single precision" << endl
+         << " -w use 64 bit vertex indices" << endl
+         << " -i start each calculation from the expected results" << endl
+         << " -v calculate the results as personalized pagerank for seed "
+         << "sets of all vertices" << endl
+         << " -l calculate the results by pushing from seeds of all "
+         << "vertices" << endl
+         << " -u delete every tenth arc and insert it back, updating the "
+         << "results each time" << endl
+         << " -k iterate only over the vertices with both incoming and "
+         << "outgoing links" << endl
+         << " -q serve the results, and read them back over a socket after "
+         << "the server" << endl
+         << "    recalculates them" << endl
+         << " -s read each graph back from a snapshot before calculating"
+         << endl
+         << " -x build a snapshot of each graph from small sorted runs, "
+         << "and stream it" << endl
+         << "    from disk while calculating" << endl
+         << " -t threads" << endl
+         << "    number of threads to use for the calculations" << endl
+         << " -n processes" << endl
+         << "    number of worker processes to split the power method "
+         << "among" << endl
+         << " -g workers" << endl
+         << "    number of workers, started on their own as threads that "
+         << "meet at a socket," << endl
+         << "    to split the power method among, each reading its rows "
+         << "from a snapshot" << endl
+         << " -r walks" << endl
+         << "    estimate the results with the given number of random "
+         << "walks per vertex," << endl
+         << "    checking them at a looser tolerance" << endl
+         << " -b width" << endl
+         << "    add up the power method's contributions in bins of the "
+         << "given width" << endl
+         << " -o ordering" << endl
+         << "    renumber the vertices by the given ordering before "
+         << "calculating" << endl
+         << "    (degree, rcm, gorder)" << endl
+         << " -a tolerance" << endl
+         << "    freeze the vertices whose pagerank has converged to the "
+         << "given relative" << endl
+         << "    tolerance" << endl
+         << " -m solver" << endl
+         << "    iterative method to use (power, gauss-seidel)" << endl
+         << " -e extrapolation" << endl
+         << "    extrapolation method to accelerate the power method with "
+         << "(none, aitken, quadratic)" << endl;
 }
 
 int main(int argc, char *argv[]) {
@@ -70,21 +204,84 @@ int main(int argc, char *argv[]) {
     Table t;
     bool java_test = false;
     bool python_test = true;
+    bool snapshot_test = false;
+    bool start_test = false;
+    bool update_test = false;
+    bool personalized_test = false;
+    bool local_test = false;
+    bool stream_test = false;
+    bool serve_test = false;
+    unsigned long walks = 0;
+    unsigned int workers = 0;
+    string ordering;
 
-    if (argc == 3) {
-        if (!strcmp(argv[1], "-j")) {
+    if (argc < 2) {
+        usage();
+        exit(1);
+    }
+    for (int i = 1; i < argc - 1; i++) {
+        if (!strcmp(argv[i], "-j")) {
             java_test = true;
             python_test = false;
-        } else if (!strcmp(argv[1], "-p")) {
+        } else if (!strcmp(argv[i], "-p")) {
             java_test = false;
             python_test = true;
+        } else if (!strcmp(argv[i], "-f")) {
+            t.set_single_precision(true);
+        } else if (!strcmp(argv[i], "-w")) {
+            t.set_force_wide_indices(true);
+        } else if (!strcmp(argv[i], "-s")) {
+            snapshot_test = true;
+        } else if (!strcmp(argv[i], "-x")) {
+            stream_test = true;
+            t.set_run_arcs(1000);
+        } else if (!strcmp(argv[i], "-k")) {
+            t.set_skip_trivial(true);
+        } else if (!strcmp(argv[i], "-q")) {
+            serve_test = true;
+        } else if (!strcmp(argv[i], "-i")) {
+            start_test = true;
+        } else if (!strcmp(argv[i], "-v")) {
+            personalized_test = true;
+        } else if (!strcmp(argv[i], "-l")) {
+            local_test = true;
+        } else if (!strcmp(argv[i], "-u")) {
+            /*
+             * The updates stop on the size of the residual, which bounds
+             * the error less tightly than the difference of successive
+             * iterations does, so they are checked at a finer criterion.
+             */
+            update_test = true;
+            t.set_convergence(1e-7);
+        } else if (!strcmp(argv[i], "-t") && i < argc - 2) {
+            t.set_num_threads(strtol(argv[++i], NULL, 10));
+        } else if (!strcmp(argv[i], "-n") && i < argc - 2) {
+            t.set_num_processes(strtol(argv[++i], NULL, 10));
+        } else if (!strcmp(argv[i], "-g") && i < argc - 2) {
+            workers = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-r") && i < argc - 2) {
+            walks = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-b") && i < argc - 2) {
+            t.set_bin_width(strtoul(argv[++i], NULL, 10));
+        } else if (!strcmp(argv[i], "-a") && i < argc - 2) {
+            t.set_adaptive_tolerance(strtod(argv[++i], NULL));
+        } else if (!strcmp(argv[i], "-o") && i < argc - 2) {
+            ordering = argv[++i];
+        } else if (!strcmp(argv[i], "-m") && i < argc - 2) {
+            if (!t.set_solver(argv[++i])) {
+                usage();
+                exit(1);
+            }
+        } else if (!strcmp(argv[i], "-e") && i < argc - 2) {
+            if (!t.set_extrapolation(argv[++i])) {
+                usage();
+                exit(1);
+            }
+            t.set_extrapolation_period(3);
         } else {
             usage();
             exit(1);
         } 
-    } else if (argc < 2) {
-        usage();
-        exit(1);
     }
     
     string tests_filename = argv[argc - 1];
@@ -96,7 +293,8 @@ int main(int argc, char *argv[]) {
     }
 
     cout.precision(numeric_limits<double>::digits10);
-    
+
+    bool all_ok = true;
     while (!tests_file.eof()) {
         string test_line;
         getline(tests_file, test_line);
@@ -123,9 +321,94 @@ int main(int argc, char *argv[]) {
         t.set_numeric(true);
         t.set_delim(" ");
         t.set_trace(false);
-        t.read_file(graph_filename);
+        if (stream_test) {
+            t.build_snapshot(graph_filename, SNAPSHOT_FILENAME);
+            t.open_snapshot(SNAPSHOT_FILENAME);
+        } else {
+            t.read_file(graph_filename);
+        }
+        if (snapshot_test) {
+            t.write_snapshot(SNAPSHOT_FILENAME);
+            t.read_snapshot(SNAPSHOT_FILENAME);
+            remove(SNAPSHOT_FILENAME);
+        }
+        if (!ordering.empty() && !t.reorder(ordering)) {
+            usage();
+            exit(1);
+        }
+        if (start_test) {
+            t.read_pagerank(pagerank_filename);
+        }
         /* Calculate pagerank */
-        t.pagerank();
+        if (personalized_test) {
+            /*
+             * A seed set of all the vertices gives the pagerank; there
+             * are more sets than are iterated together.
+             */
+            for (size_t s = 0; s <= SEED_BLOCK; s++) {
+                for (size_t i = 0; i < t.get_num_rows(); i++) {
+                    t.add_seed(to_string(s), t.get_node_name(i));
+                }
+            }
+            t.personalized_pagerank([](size_t) {});
+        } else if (walks > 0) {
+            t.monte_carlo_pagerank(walks);
+        } else if (workers > 0) {
+            /*
+             * The other workers are threads of their own, with the
+             * settings that the workers have to agree on.
+             */
+            t.write_snapshot(SNAPSHOT_FILENAME);
+            vector<thread> others;
+            for (unsigned int w = 1; w < workers; w++) {
+                others.push_back(thread([&t, w, workers]() {
+                    Table u;
+                    u.set_single_precision(t.get_single_precision());
+                    u.set_convergence(t.get_convergence());
+                    u.set_num_processes(workers);
+                    u.set_worker(w, SOCKET_FILENAME);
+                    u.worker_pagerank(SNAPSHOT_FILENAME);
+                }));
+            }
+            t.set_num_processes(workers);
+            t.set_worker(0, SOCKET_FILENAME);
+            t.worker_pagerank(SNAPSHOT_FILENAME);
+            for (size_t k = 0; k < others.size(); k++) {
+                others[k].join();
+            }
+            remove(SNAPSHOT_FILENAME);
+        } else if (!local_test) {
+            t.pagerank();
+        }
+        if (stream_test) {
+            remove(SNAPSHOT_FILENAME);
+        }
+        if (update_test) {
+            vector<string> changes;
+            ifstream graph_file(graph_filename.c_str());
+            string graph_line;
+            for (size_t k = 0; getline(graph_file, graph_line); k++) {
+                if (k % 10 == 0) {
+                    changes.push_back(graph_line);
+                }
+            }
+            for (int insert = 0; insert < 2; insert++) {
+                for (size_t k = 0; k < changes.size(); k++) {
+                    string::size_type sep = changes[k].find(" ");
+                    if (sep == string::npos) {
+                        continue;
+                    }
+                    string from = changes[k].substr(0, sep);
+                    string to = changes[k].substr(sep + 1);
+                    if (insert) {
+                        t.insert_arc(from, to);
+                    } else {
+                        t.delete_arc(from, to);
+                    }
+                }
+                t.update_pagerank();
+            }
+        }
 
         /* Read pagerank test results file */
         vector<double> pagerank_test_values;
@@ -153,6 +436,21 @@ int main(int argc, char *argv[]) {
 
         /* Compare test results with calculated results */
         vector<double> pagerank_results = t.get_pagerank();
+        if (serve_test) {
+            pagerank_results = served_pagerank(t);
+        }
+        if (local_test) {
+            vector<size_t> seeds;
+            for (size_t i = 0; i < t.get_num_rows(); i++) {
+                seeds.push_back(i);
+            }
+            vector< pair<size_t, double> > ranks;
+            t.local_pagerank(seeds, 1e-12, 0, ranks);
+            pagerank_results.assign(t.get_num_rows(), 0);
+            for (size_t k = 0; k < ranks.size(); k++) {
+                pagerank_results[ranks[k].first] = ranks[k].second;
+            }
+        }
 
         bool test_ok = true;
         for (unsigned int i = 0; i < pagerank_results.size(); i++) {
@@ -161,7 +459,13 @@ int main(int argc, char *argv[]) {
             size_t test_index = strtol(name.c_str(), NULL, 10);
             double test_result = pagerank_test_values[test_index];
             double diff = abs(result - test_result);
-            if (diff > EPSILON) {
+            double tolerance = EPSILON;
+            if (walks > 0) {
+                double n = pagerank_results.size();
+                tolerance = max(tolerance, WALK_DEVIATIONS
+                                * sqrt(test_result / (n * walks)));
+            }
+            if (diff > tolerance) {
                 cout << " error in calculation for " << name << ": "
                      << "result=" << result << " "
                      << "expected=" << test_result << " "
@@ -174,7 +478,9 @@ int main(int argc, char *argv[]) {
             cout << " OK" << endl;
         } else {
             cout << " Failed" << endl;
+            all_ok = false;
         }
     }
-    
+
+    return all_ok ? 0 : 1;
 }